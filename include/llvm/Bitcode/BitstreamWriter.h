@@ -99,6 +99,19 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Backpatch the 32 bits at bit position \p BitNo, which need not be
+  /// aligned, but must already have been flushed to the output.
+  void BackpatchBits(uint64_t BitNo, uint32_t NewBits) {
+    unsigned ByteNo = BitNo / 8, Shift = BitNo % 8;
+    assert(ByteNo + (Shift ? 5 : 4) <= Out.size() && "Bits not flushed yet");
+    uint64_t Mask = uint64_t(0xFFFFFFFF) << Shift;
+    uint64_t Value = uint64_t(NewBits) << Shift;
+    for (unsigned i = 0, e = Shift ? 5 : 4; i != e; ++i) {
+      unsigned char &Byte = reinterpret_cast<unsigned char &>(Out[ByteNo + i]);
+      Byte = (Byte & ~(Mask >> (i * 8))) | (Value >> (i * 8));
+    }
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
@@ -42,7 +42,9 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    FUNCTION_INDEX_BLOCK_ID
   };
 
 
@@ -73,6 +75,10 @@ namespace bitc {
 
     MODULE_CODE_GCNAME      = 11,  // GCNAME: [strchr x N]
     MODULE_CODE_COMDAT      = 12,  // COMDAT: [selection_kind, name]
+
+    // FNINDEXOFFSET: [lo32, hi32: offset of the FUNCTION_INDEX_BLOCK, in bits
+    //                 from the start of the module block contents]
+    MODULE_CODE_FNINDEXOFFSET = 13
   };
 
   /// PARAMATTR blocks have code for defining a parameter attribute set.
@@ -369,6 +375,15 @@ namespace bitc {
     USELIST_CODE_BB      = 2  // BB: [index..., bb-id]
   };
 
+  /// The function index block (FUNCTION_INDEX_BLOCK_ID) follows the function
+  /// blocks, and records where each of them is, so that a lazy reader can
+  /// jump to a function body without scanning the ones before it.
+  enum FunctionIndexCodes {
+    // ENTRY: [valueid, offset in bits from the start of the module block
+    //         contents, just past the function block's ENTER_SUBBLOCK]
+    FNINDEX_CODE_ENTRY = 1
+  };
+
   enum AttributeKindCodes {
     // = 0 is unused
     ATTR_KIND_ALIGNMENT = 1,
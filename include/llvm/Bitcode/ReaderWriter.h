@@ -14,12 +14,14 @@
 #ifndef LLVM_BITCODE_READERWRITER_H
 #define LLVM_BITCODE_READERWRITER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
   class BitstreamWriter;
@@ -31,13 +33,16 @@ namespace llvm {
 
   /// Read the header of the specified bitcode buffer and prepare for lazy
   /// deserialization of function bodies. If ShouldLazyLoadMetadata is true,
-  /// lazily load metadata as well. If successful, this moves Buffer. On
-  /// error, this *does not* move Buffer.
+  /// lazily load metadata as well. If ShouldReuseNamedTypes is true, named
+  /// struct types identical to one already in the context (same name, same
+  /// body) are shared with it instead of being renamed. If successful, this
+  /// moves Buffer. On error, this *does not* move Buffer.
   ErrorOr<std::unique_ptr<Module>>
   getLazyBitcodeModule(std::unique_ptr<MemoryBuffer> &&Buffer,
                        LLVMContext &Context,
                        DiagnosticHandlerFunction DiagnosticHandler = nullptr,
-                       bool ShouldLazyLoadMetadata = false);
+                       bool ShouldLazyLoadMetadata = false,
+                       bool ShouldReuseNamedTypes = false);
 
   /// Read the header of the specified stream and prepare for lazy
   /// deserialization and streaming of function bodies.
@@ -58,6 +63,15 @@ namespace llvm {
   parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
                    DiagnosticHandlerFunction DiagnosticHandler = nullptr);
 
+  /// Materialize only the named functions of a lazily read module, and turn
+  /// every other function whose body is still in the bitcode into a
+  /// declaration. A name of the form "0x<hex>" designates the function
+  /// translated from the machine code at that address, "fn_<HEX>".
+  /// Returns the names that don't match any function in \p Missing.
+  std::error_code materializeFunctionsOnly(Module &M,
+                                           ArrayRef<std::string> Names,
+                                           std::vector<std::string> &Missing);
+
   /// \brief Write the specified module to the specified raw output stream.
   ///
   /// For streams where it matters, the given stream should be in "binary"
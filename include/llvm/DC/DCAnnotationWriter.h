@@ -17,8 +17,10 @@
 #ifndef LLVM_DC_DCANNOTATIONWRITER_H
 #define LLVM_DC_DCANNOTATIONWRITER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/DC/DCTranslatedInstTracker.h"
 #include "llvm/IR/AssemblyAnnotationWriter.h"
+#include "llvm/Support/Allocator.h"
 
 namespace llvm {
 class MCInstPrinter;
@@ -27,15 +29,48 @@ class MCRegisterInfo;
 class MCSubtargetInfo;
 
 class DCAnnotationWriter : public AssemblyAnnotationWriter {
+public:
+  enum AnnotationFormat {
+    // Print the instruction address and text with every annotated value.
+    Full,
+    // Print them only once per group of consecutive values coming from the
+    // same instruction.
+    Compact,
+    // Only print the address; the text is available through writeInstTable.
+    AddressOnly
+  };
+
+private:
   const DCTranslatedInstTracker &DTIT;
   const MCRegisterInfo &MRI;
   MCInstPrinter &IP;
   const MCSubtargetInfo &STI;
+  AnnotationFormat Format;
+
+  // Printed instruction text, computed once per decoded instruction.
+  DenseMap<const MCDecodedInst *, StringRef> InstText;
+  BumpPtrAllocator InstTextAllocator;
+
+  // The instruction described by the last printed comment, for Compact.
+  const MCDecodedInst *LastMCDI;
+
+  StringRef getInstText(const MCDecodedInst &MCDI);
 
 public:
   DCAnnotationWriter(const DCTranslatedInstTracker &DTIT,
                      const MCRegisterInfo &MRI, MCInstPrinter &IP,
-                     const MCSubtargetInfo &STI);
+                     const MCSubtargetInfo &STI, AnnotationFormat Format = Full);
+
+  void setFormat(AnnotationFormat F) { Format = F; }
+  AnnotationFormat getFormat() const { return Format; }
+
+  // Write an "address<tab>instruction" line for every instruction referenced
+  // by the comments printed so far, sorted by address.
+  void writeInstTable(raw_ostream &OS) const;
+
+  void emitFunctionAnnot(const Function *, formatted_raw_ostream &) override;
+  void emitBasicBlockStartAnnot(const BasicBlock *,
+                                formatted_raw_ostream &) override;
 
   // Only for instructions, we don't care about global values
   void printInfoComment(const Value &, formatted_raw_ostream &) override;
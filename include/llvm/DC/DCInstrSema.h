@@ -38,6 +38,7 @@
 
 namespace llvm {
 class MCContext;
+class DCReadOnlyImage;
 class DCTranslatedInst;
 
 class DCInstrSema {
@@ -74,6 +75,10 @@ public:
   //   call %translated_pc(%regset* %regset_ptr)
   void setDynTranslateAtCallback(void *FnPtr) { DynTranslateAtCBPtr = FnPtr; }
 
+  // Set the read-only view of the translated image.  When set, loads from
+  // constant addresses in immutable ranges are replaced by the loaded value.
+  void setReadOnlyImage(const DCReadOnlyImage *Image) { ROImage = Image; }
+
 private:
   // Autogenerated by tblgen
   const unsigned *OpcodeToSemaIdx;
@@ -86,6 +91,7 @@ protected:
 
   // Following members are always valid.
   void *DynTranslateAtCBPtr;
+  const DCReadOnlyImage *ROImage;
 
   // Following members are valid only inside a Module.
   LLVMContext *Ctx;
@@ -165,6 +171,12 @@ private:
   void translateBinOp(Instruction::BinaryOps Opc);
   void translateCastOp(Instruction::CastOps Opc);
 
+  Value *foldReadOnlyLoad(Value *Addr, Type *ResType);
+
+  // Tag the guest memory accesses in TheFunction, so that alias analysis can
+  // tell them apart from the regset.
+  void annotateGuestMemoryAccesses();
+
   BasicBlock *insertCallBB(Value *CallTarget);
 
   void prepareBasicBlockForInsertion(BasicBlock *BB);
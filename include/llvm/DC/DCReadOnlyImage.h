@@ -0,0 +1,75 @@
+//===-- llvm/DC/DCReadOnlyImage.h - DC Read-only Image View -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the DCReadOnlyImage class, a view of the parts of an
+// object file image that are known not to change at runtime.
+//
+// DCInstrSema uses it to fold loads from constant addresses (literal pools,
+// ADRP+LDR from __TEXT,__const, ...) into the loaded value.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DC_DCREADONLYIMAGE_H
+#define LLVM_DC_DCREADONLYIMAGE_H
+
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+namespace object {
+class ObjectFile;
+class MachOObjectFile;
+}
+
+class DCReadOnlyImage {
+public:
+  /// Build the read-only view of \p Obj.
+  /// Only MachO is supported; other formats get an empty image, which never
+  /// folds anything.
+  static std::unique_ptr<DCReadOnlyImage> create(const object::ObjectFile &Obj);
+
+  /// Read a \p Size bytes wide value at \p Addr.
+  /// \returns false if any of the bytes isn't known to be immutable.
+  bool read(uint64_t Addr, unsigned Size, uint64_t &Val) const;
+
+  bool empty() const { return Ranges.empty(); }
+
+private:
+  struct Range {
+    uint64_t Begin, End;
+    StringRef Contents;
+    bool operator<(const Range &RHS) const { return Begin < RHS.Begin; }
+  };
+
+  // Sorted, non-overlapping immutable section contents.
+  std::vector<Range> Ranges;
+
+  // Sorted, merged [Begin, End) address ranges, that are patched by the
+  // loader or linker (rebase, bind, relocations), even though they live in
+  // an immutable range.
+  std::vector<std::pair<uint64_t, uint64_t>> Excluded;
+
+  bool IsLittleEndian;
+
+  explicit DCReadOnlyImage(bool IsLittleEndian)
+      : IsLittleEndian(IsLittleEndian) {}
+
+  void addMachO(const object::MachOObjectFile &MachO);
+  void addExcluded(uint64_t Begin, uint64_t Size) {
+    Excluded.push_back(std::make_pair(Begin, Begin + Size));
+  }
+  void finalize();
+};
+
+} // end namespace llvm
+
+#endif
@@ -38,6 +38,7 @@ class DataLayout;
 class Function;
 class LLVMContext;
 class MCDecodedInst;
+class MDNode;
 class MCInstrInfo;
 class MCRegisterInfo;
 class Module;
@@ -93,6 +94,10 @@ protected:
   Module *TheModule;
   LLVMContext *Ctx;
   StructType *RegSetType;
+  // TBAA access tags for the regset and for guest memory. Registers live in a
+  // host buffer that guest code can't address, so the two never alias.
+  MDNode *RegSetTBAATag;
+  MDNode *GuestMemTBAATag;
   typedef IRBuilder<true, NoFolder> DCIRBuilder;
   std::unique_ptr<DCIRBuilder> Builder;
 
@@ -124,6 +129,8 @@ protected:
 
 public:
   StructType *getRegSetType() const { return RegSetType; }
+  MDNode *getRegSetTBAATag() const { return RegSetTBAATag; }
+  MDNode *getGuestMemTBAATag() const { return GuestMemTBAATag; }
   // Compute the register's offset in bytes from the start of the regset.
   // Also return it's size in bytes.
   std::pair<size_t, size_t> getRegSizeOffsetInRegSet(unsigned RegNo) const;
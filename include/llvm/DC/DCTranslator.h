@@ -43,9 +43,9 @@ class DCRegisterSema;
 namespace TransOpt {
 enum Level {
   None,      // Generate everything as-is
-  Less,      // Enable mem2reg
-  Default,   //        + dce
-  Aggressive //        + instcombine, ..
+  Less,      // Enable sroa, early-cse, instcombine
+  Default,   //        + dse, simplifycfg, dce
+  Aggressive //        + gvn, ..
 };
 }
 
@@ -89,7 +89,14 @@ public:
 
   void printCurrentModule(raw_ostream &OS);
 
+  // Null unless IR annotation was enabled.
+  DCAnnotationWriter *getAnnotationWriter() { return AnnotWriter.get(); }
+
 private:
+  // Add the passes run on each translated function, either for OptLevel, or
+  // as given by -dc-passes.
+  void addTranslationPasses(legacy::FunctionPassManager &FPM);
+
   void
   translateFunction(MCFunction *MCFN,
                     const MCObjectDisassembler::AddressSetTy &TailCallTargets);
@@ -23,13 +23,21 @@ public:
   void generate(DWARFContext *CTX);
   uint32_t findAddress(uint64_t Address) const;
 
+  /// Build the ranges from the .debug_aranges section alone, leaving the
+  /// units it doesn't describe to addUnitsWithoutAranges.
+  void generateFromSection(DWARFContext *CTX);
+  /// Add the ranges of the units not described by .debug_aranges, which may
+  /// mean parsing their DIEs. Returns false if that was already done.
+  bool addUnitsWithoutAranges(DWARFContext *CTX);
+
 private:
   void clear();
   void extract(DataExtractor DebugArangesData);
+  void appendUnitsWithoutAranges(DWARFContext *CTX);
 
   // Call appendRange multiple times and then call construct.
   void appendRange(uint32_t CUOffset, uint64_t LowPC, uint64_t HighPC);
-  void construct();
+  void construct(bool KeepEndpoints = false);
 
   struct Range {
     explicit Range(uint64_t LowPC = -1ULL, uint64_t HighPC = -1ULL,
@@ -80,6 +88,7 @@ private:
   std::vector<RangeEndpoint> Endpoints;
   RangeColl Aranges;
   DenseSet<uint32_t> ParsedCUOffsets;
+  bool HasAllUnits = false;
 };
 
 }
@@ -72,6 +72,15 @@ public:
   /// Returns true on error.
   bool linkInModule(Module *Src, bool OverrideSymbols = false);
 
+  /// \brief Link \p Shards, pieces of the same program, into the composite.
+  /// The shards are expected to define disjoint sets of symbols, and to share
+  /// the composite's identified struct types (see ShouldReuseNamedTypes in
+  /// getLazyBitcodeModule). Their global values are then moved over as they
+  /// are, and each declaration is resolved with a single symbol lookup.
+  /// A shard that doesn't fit these assumptions goes through linkInModule.
+  /// The shards are destroyed. Returns true on error.
+  bool linkDisjointShards(ArrayRef<Module *> Shards);
+
   /// \brief Set the composite to the passed-in module.
   void setModule(Module *Dst);
 
@@ -82,6 +91,7 @@ public:
 
 private:
   void init(Module *M, DiagnosticHandlerFunction DiagnosticHandler);
+  bool linkDisjointShard(Module *Src);
   Module *Composite;
 
   IdentifiedStructTypeSet IdentifiedStructTypes;
@@ -15,6 +15,7 @@
 #ifndef LLVM_MC_MCANALYSIS_MCMODULE_H
 #define LLVM_MC_MCANALYSIS_MCMODULE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
@@ -39,6 +40,30 @@ class MCModule {
   DenseMap<uint64_t, MCFunction *> FunctionsByAddr;
   /// @}
 
+  /// \name Symbolic operand tracking
+  /// @{
+public:
+  /// \brief An instruction operand that a compact MCObjectSymbolizer left as
+  /// an immediate. The expression for it can be built on demand using
+  /// MCObjectSymbolizer::materializeSymbolicOperands.
+  struct SymbolicOperand {
+    /// The address of the instruction.
+    uint64_t InstAddr;
+    /// The address the operand refers to, or, for relocated operands, the
+    /// address of the relocation.
+    uint64_t TargetAddr;
+    /// The index of the symbol in the symbolizer's operand symbol table.
+    uint32_t SymbolIdx;
+    /// The index of the operand in the instruction.
+    uint32_t OpIdx;
+  };
+
+private:
+  // Sorted by InstAddr, then OpIdx, when SymbolicOperandsSorted is true.
+  mutable std::vector<SymbolicOperand> SymbolicOperands;
+  mutable bool SymbolicOperandsSorted;
+  /// @}
+
   MCModule           (const MCModule &) = delete;
   MCModule& operator=(const MCModule &) = delete;
 
@@ -54,6 +79,16 @@ public:
 
   MCFunction *findFunctionAt(uint64_t BeginAddr);
 
+  /// \brief Record a symbolic operand of the instruction at \p InstAddr.
+  void addSymbolicOperand(uint64_t InstAddr, uint64_t TargetAddr,
+                          uint32_t SymbolIdx, uint32_t OpIdx);
+
+  /// \brief Get the symbolic operands recorded for the instruction at
+  /// \p InstAddr, ordered by operand index.
+  ArrayRef<SymbolicOperand> getSymbolicOperands(uint64_t InstAddr) const;
+
+  size_t getNumSymbolicOperands() const { return SymbolicOperands.size(); }
+
   /// \name Access to the owned function list.
   /// @{
   typedef FunctionListTy::const_iterator const_func_iterator;
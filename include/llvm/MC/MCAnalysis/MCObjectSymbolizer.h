@@ -17,6 +17,7 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/MC/MCAnalysis/MCModule.h"
 #include "llvm/MC/MCSymbolizer.h"
 #include "llvm/Object/ObjectFile.h"
 #include <vector>
@@ -64,6 +65,30 @@ public:
   /// \returns The function's name, or the empty string if not found.
   virtual StringRef findExternalFunctionAt(uint64_t Addr);
 
+  /// \name Compact symbolic operands.
+  /// In compact mode, tryAddingSymbolicOperand doesn't create any expression
+  /// in the MCContext. It leaves the operand as an immediate, and records it
+  /// in the operand module's symbolic operand table instead, so that printers
+  /// can build the expression when they actually need it.
+  /// @{
+  void setCompactOperands(bool Compact) { CompactOperands = Compact; }
+  bool hasCompactOperands() const { return CompactOperands; }
+
+  /// \brief Set the module compact symbolic operands are recorded in.
+  /// This is done by MCObjectDisassembler when it creates the module.
+  void setOperandModule(MCModule *Module) { OperandModule = Module; }
+
+  /// \brief Build the expression for an operand recorded in compact mode.
+  /// \returns nullptr if there is no expression for it.
+  const MCExpr *
+  createSymbolicOperandExpr(const MCModule::SymbolicOperand &SO);
+
+  /// \brief Replace the operands of \p MI, the instruction at \p Addr, that
+  /// were recorded in \p Module with their symbolic expressions.
+  void materializeSymbolicOperands(MCInst &MI, uint64_t Addr,
+                                   const MCModule &Module);
+  /// @}
+
   /// \brief Get the effective address of the entrypoint, or 0 if there is none.
   virtual uint64_t getEntrypoint();
 
@@ -94,23 +119,37 @@ protected:
   };
 
   struct SectionInfo {
-    SectionInfo(object::SectionRef S) : Section(S) {}
+    SectionInfo(object::SectionRef S)
+        : Section(S), Addr(S.getAddress()), Size(S.getSize()) {}
     object::SectionRef Section;
+    uint64_t Addr;
+    uint64_t Size;
     std::vector<object::RelocationRef> Relocs;
-    bool operator<(uint64_t Addr) const {
-      return Section.getAddress() + Section.getSize() <= Addr;
-    }
-    bool operator<(const SectionInfo &RHS) const {
-      return Section.getAddress() < RHS.Section.getAddress();
-    }
+    bool operator<(const SectionInfo &RHS) const { return Addr < RHS.Addr; }
   };
 
+  // A symbol referenced by compact symbolic operands, and the address it
+  // stands for.
+  struct OperandSymbol {
+    MCSymbol *Sym;
+    uint64_t Addr;
+  };
+  // The SymbolIdx of operands that are relocated.
+  enum : uint32_t { RelocationSymbolIdx = ~0U };
 
   // FIXME: Just keep the uint64_t ?
   std::vector<std::pair<object::SymbolRef, uint64_t>> SymbolSizes;
+  // Non-empty sections, sorted by address.
   std::vector<SectionInfo> SortedSections;
   std::vector<FunctionSymbol> AddrToFunctionSymbol;
 
+  bool CompactOperands;
+  MCModule *OperandModule;
+  std::vector<OperandSymbol> OperandSymbols;
+  DenseMap<std::pair<MCSymbol *, uint64_t>, uint32_t> OperandSymbolIndices;
+
+  uint32_t getOperandSymbolIdx(MCSymbol *Sym, uint64_t Addr);
+
   void buildAddrToFunctionSymbolMap();
   void buildSectionList();
   void buildRelocationByAddrMap(SectionInfo &SecInfo);
@@ -11,6 +11,7 @@
 
 #include "llvm-c/Disassembler.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/MC/MCSymbolizer.h"
 #include "llvm/Support/DataTypes.h"
 
@@ -78,6 +79,42 @@ public:
                                       raw_ostream &VStream,
                                       raw_ostream &CStream) const = 0;
 
+  /// Returns the disassembly of consecutive instructions.
+  ///
+  /// Decoding stops at the first instruction that fails to decode, when
+  /// \p Insts is full, or when \p Bytes is exhausted.
+  ///
+  /// \param Bytes       - The bytes to decode, starting with the first
+  ///                      instruction.
+  /// \param Address     - The address of the first byte of \p Bytes.
+  /// \param Insts       - The MCInsts to populate, in order.  Their operand
+  ///                      storage is reused, so callers should keep the same
+  ///                      MCInsts around between calls.
+  /// \param Sizes       - Cleared, then populated with the size of each
+  ///                      decoded instruction.
+  /// \param VStream     - The stream to print warnings and diagnostic
+  ///                      messages on.
+  /// \param CStream     - The stream to print comments and annotations on.
+  /// \param CommentEnds - If not null, cleared, then populated with
+  ///                      CStream.tell() after each decoded instruction, so
+  ///                      that the comments of each instruction can be told
+  ///                      apart.
+  /// \return            - The number of instructions decoded, which were
+  ///                      either valid or disassemblable but invalid
+  ///                      (SoftFail).
+  ///
+  /// The default implementation calls getInstruction for each instruction.
+  virtual size_t getInstructions(ArrayRef<uint8_t> Bytes, uint64_t Address,
+                                 MutableArrayRef<MCInst> Insts,
+                                 SmallVectorImpl<uint64_t> &Sizes,
+                                 raw_ostream &VStream, raw_ostream &CStream,
+                                 SmallVectorImpl<uint64_t> *CommentEnds) const;
+
+  /// Same as above, discarding comments and diagnostics.
+  size_t getInstructions(ArrayRef<uint8_t> Bytes, uint64_t Address,
+                         MutableArrayRef<MCInst> Insts,
+                         SmallVectorImpl<uint64_t> &Sizes) const;
+
 private:
   MCContext &Ctx;
 
@@ -69,6 +69,8 @@ public:
   /// \brief Set the symbolizer to use to get information on external functions.
   /// Note that this isn't used to do instruction-level symbolization (that is,
   /// plugged into MCDisassembler), but to symbolize function call targets.
+  /// If it has compact operands, it is also told about the modules that are
+  /// built, to record the symbolic operands there.
   void setSymbolizer(MCObjectSymbolizer *ObjectSymbolizer) {
     MOS = ObjectSymbolizer;
   }
@@ -20,6 +20,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/MachO.h"
+#include <memory>
 
 namespace llvm {
 namespace object {
@@ -193,8 +194,23 @@ public:
   typedef SmallVector<LoadCommandInfo, 4> LoadCommandList;
   typedef LoadCommandList::const_iterator load_command_iterator;
 
+  /// \brief A segment load command, 32 or 64-bit.
+  struct SegmentInfo {
+    StringRef Name;
+    uint64_t VMAddr;
+    uint64_t VMSize;
+    uint64_t FileOff;
+    uint64_t FileSize;
+    uint32_t MaxProt;
+    uint32_t InitProt;
+    /// The index of the segment, in load command order, as used by the
+    /// rebase and bind tables.
+    unsigned Index;
+  };
+
   MachOObjectFile(MemoryBufferRef Object, bool IsLittleEndian, bool Is64Bits,
                   std::error_code &EC);
+  ~MachOObjectFile() override;
 
   void moveSymbolNext(DataRefImpl &Symb) const override;
 
@@ -418,6 +434,33 @@ public:
 
   bool hasPageZeroSegment() const { return HasPageZeroSegment; }
 
+  /// \name Section and segment lookup.
+  /// These use an index of the sections and segments, sorted once, and built
+  /// on first use.
+  /// @{
+
+  /// \brief Find the section \p SectName in the segment \p SegName, or in any
+  /// segment if \p SegName is empty. If there are several, the first one in
+  /// load command order is returned.
+  /// \returns section_end() if there is no such section.
+  section_iterator findSection(StringRef SegName, StringRef SectName) const;
+
+  /// \brief Get the sections of type \p Type (one of MachO::SectionType), in
+  /// load command order.
+  ArrayRef<SectionRef> sectionsOfType(unsigned Type) const;
+
+  /// \brief Get the segments, in load command order.
+  ArrayRef<SegmentInfo> segments() const;
+
+  /// \brief Find the segment whose virtual memory range contains \p VMAddr.
+  /// \returns nullptr if there is none.
+  const SegmentInfo *findSegmentContaining(uint64_t VMAddr) const;
+
+  /// \brief Find the segment whose file contents contain \p FileOffset.
+  /// \returns nullptr if there is none.
+  const SegmentInfo *findSegmentForFileOffset(uint64_t FileOffset) const;
+  /// @}
+
   static bool classof(const Binary *v) {
     return v->isMachO();
   }
@@ -461,6 +504,10 @@ private:
   const char *DyldInfoLoadCmd;
   const char *UuidLoadCmd;
   bool HasPageZeroSegment;
+
+  struct LookupIndex;
+  mutable std::unique_ptr<LookupIndex> Index;
+  const LookupIndex &getLookupIndex() const;
 };
 
 /// DiceRef
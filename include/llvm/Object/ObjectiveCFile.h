@@ -109,7 +109,7 @@ namespace llvm {
         StringRef getMethodName(ArrayRef<uint8_t> &ObjcMethodnames, uint64_t ObjcMethodnamesAddress, uint64_t Address);
 
         StringRef getClassName(uint64_t Pointer);
-        MachO::segment_command_64 getSegment(uint64_t SegmentNo);
+        const object::MachOObjectFile::SegmentInfo &getSegment(uint64_t SegmentNo);
     };
 
 }
@@ -17,11 +17,13 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <map>
 #include <vector>
 
 namespace llvm {
@@ -30,8 +32,15 @@ namespace llvm {
 class InstrProfWriter {
 public:
   typedef SmallDenseMap<uint64_t, std::vector<uint64_t>, 1> CounterData;
+  /// Counts summed by function hash and number of counters.
+  typedef std::map<std::pair<uint64_t, size_t>, std::vector<uint64_t>>
+      MismatchedCounterData;
 private:
   StringMap<CounterData> FunctionData;
+  /// The counts whose number of counters didn't match the counts first added
+  /// for the same function and hash. They aren't written, but a writer
+  /// merged into this one may have first added counts that they match.
+  StringMap<MismatchedCounterData> MismatchedData;
   uint64_t MaxFunctionCount;
 public:
   InstrProfWriter() : MaxFunctionCount(0) {}
@@ -42,6 +51,12 @@ public:
   std::error_code addFunctionCounts(StringRef FunctionName,
                                     uint64_t FunctionHash,
                                     ArrayRef<uint64_t> Counters);
+  /// Add the counts of all the functions in \p IPW, as if they had been
+  /// added to this writer after its own. \p Warn is called for each
+  /// function whose counts couldn't be merged.
+  void mergeRecordsFromWriter(
+      InstrProfWriter &&IPW,
+      function_ref<void(StringRef, std::error_code)> Warn);
   /// Write the profile to \c OS
   void write(raw_fd_ostream &OS);
   /// Write the profile, returning the raw data. For testing.
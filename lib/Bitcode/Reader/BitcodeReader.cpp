@@ -9,11 +9,14 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
@@ -28,14 +31,22 @@
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/thread.h"
+#include <atomic>
 #include <deque>
 using namespace llvm;
 
+static cl::opt<unsigned> NumDecodeThreads(
+    "bitcode-reader-threads", cl::init(1),
+    cl::desc("Number of threads decoding function blocks ahead of time "
+             "when a whole bitcode module is materialized"));
+
 namespace {
 enum {
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
@@ -138,6 +149,81 @@ public:
   void tryToResolveCycles();
 };
 
+/// The records of a function block, decoded off the main thread.
+/// The sub-blocks (constants, symbol table, metadata, ...) are not decoded:
+/// they create values as they are read, so only their position is kept.
+class DecodedFunctionBody {
+  struct Entry {
+    bool IsSubBlock;
+    unsigned Code;         // The record code, or the sub-block ID.
+    uint64_t SubBlockBit;  // Position past the sub-block ID.
+    unsigned OpsBegin, OpsEnd;
+  };
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+  unsigned NextEntry = 0;
+
+public:
+  /// Decode the function block at \p BitNo, just past its ID.
+  /// \returns false if the block is malformed.
+  bool decode(BitstreamCursor &Cursor, uint64_t BitNo);
+
+  /// Return the next entry, like BitstreamCursor::advance.
+  /// Sub-blocks are left for \p Stream to read.
+  BitstreamEntry advance(BitstreamCursor &Stream) {
+    if (NextEntry == Entries.size())
+      return BitstreamEntry::getEndBlock();
+    const Entry &E = Entries[NextEntry++];
+    if (!E.IsSubBlock)
+      return BitstreamEntry::getRecord(0);
+    Stream.JumpToBit(E.SubBlockBit);
+    return BitstreamEntry::getSubBlock(E.Code);
+  }
+
+  /// Read the record returned by the last call to advance().
+  unsigned readRecord(SmallVectorImpl<uint64_t> &Vals) {
+    const Entry &E = Entries[NextEntry - 1];
+    Vals.append(Ops.begin() + E.OpsBegin, Ops.begin() + E.OpsEnd);
+    return E.Code;
+  }
+};
+
+bool DecodedFunctionBody::decode(BitstreamCursor &Cursor, uint64_t BitNo) {
+  Cursor.JumpToBit(BitNo);
+  if (Cursor.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+    return false;
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry BE = Cursor.advance();
+    Entry E;
+    switch (BE.Kind) {
+    case BitstreamEntry::Error:
+      return false;
+    case BitstreamEntry::EndBlock:
+      return true;
+    case BitstreamEntry::SubBlock:
+      E.IsSubBlock = true;
+      E.Code = BE.ID;
+      E.SubBlockBit = Cursor.GetCurrentBitNo();
+      E.OpsBegin = E.OpsEnd = 0;
+      if (Cursor.SkipBlock())
+        return false;
+      break;
+    case BitstreamEntry::Record:
+      Record.clear();
+      E.IsSubBlock = false;
+      E.Code = Cursor.readRecord(BE.ID, Record);
+      E.SubBlockBit = 0;
+      E.OpsBegin = Ops.size();
+      Ops.insert(Ops.end(), Record.begin(), Record.end());
+      E.OpsEnd = Ops.size();
+      break;
+    }
+    Entries.push_back(E);
+  }
+}
+
 class BitcodeReader : public GVMaterializer {
   LLVMContext &Context;
   DiagnosticHandlerFunction DiagnosticHandler;
@@ -148,6 +234,15 @@ class BitcodeReader : public GVMaterializer {
   uint64_t NextUnreadBit = 0;
   bool SeenValueSymbolTable = false;
 
+  /// The position of the module block contents, and of the function index
+  /// relative to it, if the module has one.
+  uint64_t ModuleBitBase = 0;
+  uint64_t FunctionIndexOffset = 0;
+
+  /// Whether the bytes are fetched on demand. The function index is then
+  /// ignored, as reading it would fetch the whole stream upfront.
+  bool IsStreamed = false;
+
   std::vector<Type*> TypeList;
   BitcodeReaderValueList ValueList;
   BitcodeReaderMDValueList MDValueList;
@@ -194,6 +289,11 @@ class BitcodeReader : public GVMaterializer {
   /// where to find deferred function body in the stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// Function blocks decoded ahead of time by decodeFunctionBodies, waiting
+  /// to be materialized.
+  DenseMap<Function *, std::unique_ptr<DecodedFunctionBody>>
+      DecodedFunctionBodies;
+
   /// When Metadata block is initially scanned when parsing the module, we may
   /// choose to defer parsing of the metadata. This vector contains info about
   /// which Metadata blocks are deferred.
@@ -225,6 +325,10 @@ class BitcodeReader : public GVMaterializer {
 
   bool StripDebugInfo = false;
 
+  /// Whether a named struct type whose name and body match a type already in
+  /// the context should be reused rather than renamed.
+  bool ShouldReuseNamedTypes = false;
+
 public:
   std::error_code error(BitcodeError E, const Twine &Message);
   std::error_code error(BitcodeError E);
@@ -265,6 +369,8 @@ public:
 
   void setStripDebugInfo() override;
 
+  void setShouldReuseNamedTypes(bool Reuse) { ShouldReuseNamedTypes = Reuse; }
+
 private:
   std::vector<StructType *> IdentifiedStructTypes;
   StructType *createIdentifiedStructType(LLVMContext &Context, StringRef Name);
@@ -373,9 +479,12 @@ private:
   std::error_code parseValueSymbolTable();
   std::error_code parseConstants();
   std::error_code rememberAndSkipFunctionBody();
+  std::error_code parseFunctionIndex();
   /// Save the positions of the Metadata blocks and skip parsing the blocks.
   std::error_code rememberAndSkipMetadata();
   std::error_code parseFunctionBody(Function *F);
+  /// Decode the records of the blocks of \p Fns on \p NumThreads threads.
+  void decodeFunctionBodies(ArrayRef<Function *> Fns, unsigned NumThreads);
   std::error_code globalCleanup();
   std::error_code resolveGlobalAndAliasInits();
   std::error_code parseMetadata();
@@ -1515,12 +1624,11 @@ std::error_code BitcodeReader::parseTypeTableBody() {
 
       // Check to see if this was forward referenced, if so fill in the temp.
       StructType *Res = cast_or_null<StructType>(TypeList[NumRecords]);
+      bool WasForwardReferenced = Res;
       if (Res) {
         Res->setName(TypeName);
         TypeList[NumRecords] = nullptr;
-      } else  // Otherwise, create a new struct.
-        Res = createIdentifiedStructType(Context, TypeName);
-      TypeName.clear();
+      }
 
       SmallVector<Type*, 8> EltTys;
       for (unsigned i = 1, e = Record.size(); i != e; ++i) {
@@ -1531,7 +1639,24 @@ std::error_code BitcodeReader::parseTypeTableBody() {
       }
       if (EltTys.size() != Record.size()-1)
         return error("Invalid record");
-      Res->setBody(EltTys, Record[0]);
+
+      // Modules from the same program can share their identical named types.
+      if (!WasForwardReferenced && ShouldReuseNamedTypes && !TypeName.empty())
+        if (StructType *Existing = TheModule->getTypeByName(TypeName))
+          if (!Existing->isOpaque() && Existing->isPacked() == !!Record[0] &&
+              Existing->elements() == makeArrayRef(EltTys)) {
+            Res = Existing;
+            IdentifiedStructTypes.push_back(Res);
+          }
+
+      if (!Res) {
+        // Otherwise, create a new struct.
+        Res = createIdentifiedStructType(Context, TypeName);
+        Res->setBody(EltTys, Record[0]);
+      } else if (Res->isOpaque()) {
+        Res->setBody(EltTys, Record[0]);
+      }
+      TypeName.clear();
       ResultTy = Res;
       break;
     }
@@ -2783,6 +2908,52 @@ std::error_code BitcodeReader::rememberAndSkipFunctionBody() {
   return std::error_code();
 }
 
+/// Record the position of all the function bodies listed in the function
+/// index, so that materializing one doesn't scan the ones before it.
+std::error_code BitcodeReader::parseFunctionIndex() {
+  uint64_t CurBit = Stream.GetCurrentBitNo();
+  Stream.JumpToBit(ModuleBitBase + FunctionIndexOffset);
+
+  BitstreamEntry Entry = Stream.advance();
+  if (Entry.Kind != BitstreamEntry::SubBlock ||
+      Entry.ID != bitc::FUNCTION_INDEX_BLOCK_ID ||
+      Stream.EnterSubBlock(bitc::FUNCTION_INDEX_BLOCK_ID))
+    return error("Invalid function index");
+
+  SmallVector<uint64_t, 2> Record;
+  while (1) {
+    Entry = Stream.advanceSkippingSubblocks();
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      Stream.JumpToBit(CurBit);
+      return std::error_code();
+    case BitstreamEntry::Record:
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: // Ignore unknown content.
+      break;
+    case bitc::FNINDEX_CODE_ENTRY: { // ENTRY: [valueid, offset]
+      if (Record.size() < 2 || Record[0] >= ValueList.size())
+        return error("Invalid record");
+      Function *F = dyn_cast_or_null<Function>(ValueList[Record[0]]);
+      if (!F)
+        return error("Invalid record");
+      auto DFII = DeferredFunctionInfo.find(F);
+      if (DFII == DeferredFunctionInfo.end())
+        return error("Invalid record");
+      DFII->second = ModuleBitBase + Record[1];
+      break;
+    }
+    }
+  }
+}
+
 std::error_code BitcodeReader::globalCleanup() {
   // Patch the initializers for globals and aliases up.
   resolveGlobalAndAliasInits();
@@ -2813,6 +2984,8 @@ std::error_code BitcodeReader::parseModule(bool Resume,
     Stream.JumpToBit(NextUnreadBit);
   else if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
     return error("Invalid record");
+  else
+    ModuleBitBase = Stream.GetCurrentBitNo();
 
   SmallVector<uint64_t, 64> Record;
   std::vector<std::string> SectionTable;
@@ -2879,6 +3052,9 @@ std::error_code BitcodeReader::parseModule(bool Resume,
           if (std::error_code EC = globalCleanup())
             return EC;
           SeenFirstFunctionBody = true;
+          if (FunctionIndexOffset && !IsStreamed)
+            if (std::error_code EC = parseFunctionIndex())
+              return EC;
         }
 
         if (std::error_code EC = rememberAndSkipFunctionBody())
@@ -2982,6 +3158,12 @@ std::error_code BitcodeReader::parseModule(bool Resume,
       ComdatList.push_back(C);
       break;
     }
+    case bitc::MODULE_CODE_FNINDEXOFFSET: { // FNINDEXOFFSET: [lo32, hi32]
+      if (Record.size() < 2)
+        return error("Invalid record");
+      FunctionIndexOffset = (Record[1] << 32) | (Record[0] & 0xFFFFFFFF);
+      break;
+    }
     // GLOBALVAR: [pointer type, isconst, initid,
     //             linkage, alignment, section, visibility, threadlocal,
     //             unnamed_addr, externally_initialized, dllstorageclass,
@@ -3385,8 +3567,16 @@ static std::error_code typeCheckLoadStoreInst(DiagnosticHandlerFunction DH,
 
 /// Lazily parse the specified function body block.
 std::error_code BitcodeReader::parseFunctionBody(Function *F) {
-  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+  // Use the records decoded ahead of time if there are any, otherwise read
+  // them from the stream.
+  std::unique_ptr<DecodedFunctionBody> Decoded;
+  auto DFBI = DecodedFunctionBodies.find(F);
+  if (DFBI != DecodedFunctionBodies.end()) {
+    Decoded = std::move(DFBI->second);
+    DecodedFunctionBodies.erase(DFBI);
+  } else if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID)) {
     return error("Invalid record");
+  }
 
   InstructionList.clear();
   unsigned ModuleValueListSize = ValueList.size();
@@ -3413,7 +3603,7 @@ std::error_code BitcodeReader::parseFunctionBody(Function *F) {
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry = Decoded ? Decoded->advance(Stream) : Stream.advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -3459,7 +3649,8 @@ std::error_code BitcodeReader::parseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = Decoded ? Decoded->readRecord(Record)
+                               : Stream.readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return error("Invalid value");
@@ -4637,6 +4828,48 @@ std::error_code BitcodeReader::findFunctionInStream(
 
 void BitcodeReader::releaseBuffer() { Buffer.release(); }
 
+void BitcodeReader::decodeFunctionBodies(ArrayRef<Function *> Fns,
+                                         unsigned NumThreads) {
+  // Only the blocks whose position is known can be decoded independently.
+  std::vector<std::pair<Function *, uint64_t>> Work;
+  for (Function *F : Fns) {
+    if (!F->isMaterializable() || DecodedFunctionBodies.count(F))
+      continue;
+    uint64_t BitNo = DeferredFunctionInfo.lookup(F);
+    if (BitNo)
+      Work.push_back(std::make_pair(F, BitNo));
+  }
+
+  // The cursors only read the (immutable) bytes and block info of the shared
+  // reader; each worker has its own.
+  std::vector<std::unique_ptr<DecodedFunctionBody>> Bodies(Work.size());
+  std::atomic<unsigned> NextWork(0);
+  auto Worker = [&]() {
+    for (unsigned I = NextWork++; I < Work.size(); I = NextWork++) {
+      BitstreamCursor Cursor(*StreamFile);
+      std::unique_ptr<DecodedFunctionBody> Body(new DecodedFunctionBody());
+      // A malformed block is left for parseFunctionBody to diagnose.
+      if (Body->decode(Cursor, Work[I].second))
+        Bodies[I] = std::move(Body);
+    }
+  };
+
+#if LLVM_ENABLE_THREADS
+  std::vector<std::thread> Threads;
+  for (unsigned I = 1; I < NumThreads; ++I)
+    Threads.emplace_back(Worker);
+  Worker();
+  for (std::thread &T : Threads)
+    T.join();
+#else
+  Worker();
+#endif
+
+  for (unsigned I = 0, E = Work.size(); I != E; ++I)
+    if (Bodies[I])
+      DecodedFunctionBodies[Work[I].first] = std::move(Bodies[I]);
+}
+
 std::error_code BitcodeReader::materialize(GlobalValue *GV) {
   if (std::error_code EC = materializeMetadata())
     return EC;
@@ -4717,10 +4950,28 @@ std::error_code BitcodeReader::materializeModule(Module *M) {
 
   // Iterate over the module, deserializing any functions that are still on
   // disk.
-  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
-       F != E; ++F) {
-    if (std::error_code EC = materialize(F))
-      return EC;
+  if (NumDecodeThreads > 1 && !IsStreamed) {
+    // Decode the function blocks concurrently, a window at a time to bound
+    // the memory held by the decoded records, and build the IR on this thread.
+    std::vector<Function *> Fns;
+    for (Function &F : *TheModule)
+      Fns.push_back(&F);
+    const size_t Window = 1024 * NumDecodeThreads;
+    for (size_t I = 0, E = Fns.size(); I < E; I += Window) {
+      ArrayRef<Function *> WindowFns =
+          makeArrayRef(Fns).slice(I, std::min(Window, E - I));
+      decodeFunctionBodies(WindowFns, NumDecodeThreads);
+      for (Function *F : WindowFns)
+        if (std::error_code EC = materialize(F))
+          return EC;
+    }
+    DecodedFunctionBodies.clear();
+  } else {
+    for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+         F != E; ++F) {
+      if (std::error_code EC = materialize(F))
+        return EC;
+    }
   }
   // At this point, if there are any function bodies, the current bit is
   // pointing to the END_BLOCK record after them. Now make sure the rest
@@ -4794,6 +5045,7 @@ BitcodeReader::initLazyStream(std::unique_ptr<DataStreamer> Streamer) {
   StreamingMemoryObject &Bytes = *OwnedBytes;
   StreamFile = llvm::make_unique<BitstreamReader>(std::move(OwnedBytes));
   Stream.init(&*StreamFile);
+  IsStreamed = true;
 
   unsigned char buf[16];
   if (Bytes.readBytes(buf, 16, 0) != 16)
@@ -4881,9 +5133,11 @@ static ErrorOr<std::unique_ptr<Module>>
 getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
                          LLVMContext &Context, bool MaterializeAll,
                          DiagnosticHandlerFunction DiagnosticHandler,
-                         bool ShouldLazyLoadMetadata = false) {
+                         bool ShouldLazyLoadMetadata = false,
+                         bool ShouldReuseNamedTypes = false) {
   BitcodeReader *R =
       new BitcodeReader(Buffer.get(), Context, DiagnosticHandler);
+  R->setShouldReuseNamedTypes(ShouldReuseNamedTypes);
 
   ErrorOr<std::unique_ptr<Module>> Ret =
       getBitcodeModuleImpl(nullptr, Buffer->getBufferIdentifier(), R, Context,
@@ -4897,9 +5151,11 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
 
 ErrorOr<std::unique_ptr<Module>> llvm::getLazyBitcodeModule(
     std::unique_ptr<MemoryBuffer> &&Buffer, LLVMContext &Context,
-    DiagnosticHandlerFunction DiagnosticHandler, bool ShouldLazyLoadMetadata) {
+    DiagnosticHandlerFunction DiagnosticHandler, bool ShouldLazyLoadMetadata,
+    bool ShouldReuseNamedTypes) {
   return getLazyBitcodeModuleImpl(std::move(Buffer), Context, false,
-                                  DiagnosticHandler, ShouldLazyLoadMetadata);
+                                  DiagnosticHandler, ShouldLazyLoadMetadata,
+                                  ShouldReuseNamedTypes);
 }
 
 ErrorOr<std::unique_ptr<Module>> llvm::getStreamedBitcodeModule(
@@ -4933,3 +5189,32 @@ llvm::getBitcodeTargetTriple(MemoryBufferRef Buffer, LLVMContext &Context,
     return "";
   return Triple.get();
 }
+
+std::error_code
+llvm::materializeFunctionsOnly(Module &M, ArrayRef<std::string> Names,
+                               std::vector<std::string> &Missing) {
+  SmallPtrSet<Function *, 16> Wanted;
+  for (const std::string &Name : Names) {
+    StringRef FnName = Name;
+    std::string AddrName;
+    uint64_t Addr;
+    if (FnName.startswith("0x") && !FnName.substr(2).getAsInteger(16, Addr)) {
+      AddrName = "fn_" + utohexstr(Addr);
+      FnName = AddrName;
+    }
+    if (Function *F = M.getFunction(FnName))
+      Wanted.insert(F);
+    else
+      Missing.push_back(Name);
+  }
+
+  for (Function *F : Wanted)
+    if (std::error_code EC = F->materialize())
+      return EC;
+
+  // Whatever is left in the bitcode is only needed as a declaration.
+  for (Function &F : M)
+    if (F.isMaterializable())
+      F.deleteBody();
+  return std::error_code();
+}
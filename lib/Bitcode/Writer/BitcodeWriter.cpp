@@ -2402,10 +2402,47 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+/// Emit the placeholder for the offset of the function index block, and
+/// return its bit position in the stream, for backpatching.
+static uint64_t WriteFunctionIndexOffsetPlaceholder(BitstreamWriter &Stream) {
+  // Fixed width fields, so that the record can be patched in place; a blob
+  // would be simpler, but can't be read from a streaming reader.
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_FNINDEXOFFSET));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+  unsigned AbbrevID = Stream.EmitAbbrev(Abbv);
+
+  SmallVector<uint64_t, 3> Vals;
+  Vals.push_back(0);
+  Vals.push_back(0);
+  Stream.EmitRecord(bitc::MODULE_CODE_FNINDEXOFFSET, Vals, AbbrevID);
+  return Stream.GetCurrentBitNo() - 64;
+}
+
+/// Emit the function index block: the position of each function block,
+/// relative to \p ModuleBitBase.
+static void WriteFunctionIndex(
+    ArrayRef<std::pair<unsigned, uint64_t>> FunctionBits,
+    BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::FUNCTION_INDEX_BLOCK_ID, 3);
+  SmallVector<uint64_t, 2> Vals;
+  for (const auto &FB : FunctionBits) {
+    Vals.push_back(FB.first);
+    Vals.push_back(FB.second);
+    Stream.EmitRecord(bitc::FNINDEX_CODE_ENTRY, Vals);
+    Vals.clear();
+  }
+  Stream.ExitBlock();
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream,
                         bool ShouldPreserveUseListOrder) {
-  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  const unsigned ModuleAbbrevWidth = 3;
+  Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, ModuleAbbrevWidth);
+  // Offsets in the function index are relative to this.
+  const uint64_t ModuleBitBase = Stream.GetCurrentBitNo();
 
   SmallVector<unsigned, 1> Vals;
   unsigned CurVersion = 1;
@@ -2449,10 +2486,36 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   if (VE.shouldPreserveUseListOrder())
     WriteUseListBlock(nullptr, VE, Stream);
 
-  // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  // Emit function bodies, and remember where each one is, so that lazy
+  // readers can find them without scanning all the preceding ones.
+  bool HasFunctionBodies = false;
+  for (const Function &F : *M)
+    HasFunctionBodies |= !F.isDeclaration();
+
+  if (HasFunctionBodies) {
+    uint64_t IndexOffsetPlaceholder =
+        WriteFunctionIndexOffsetPlaceholder(Stream);
+
+    std::vector<std::pair<unsigned, uint64_t>> FunctionBits;
+    for (const Function &F : *M) {
+      if (F.isDeclaration())
+        continue;
+      // The reader records the position past the ENTER_SUBBLOCK abbrev ID
+      // and the block ID, which fits in a single VBR chunk.
+      static_assert(bitc::FUNCTION_BLOCK_ID < (1 << (bitc::BlockIDWidth - 1)),
+                    "Function block ID doesn't fit in a single VBR chunk");
+      FunctionBits.push_back(std::make_pair(
+          VE.getValueID(&F), Stream.GetCurrentBitNo() - ModuleBitBase +
+                                 ModuleAbbrevWidth + bitc::BlockIDWidth));
+      WriteFunction(F, VE, Stream);
+    }
+
+    uint64_t IndexOffset = Stream.GetCurrentBitNo() - ModuleBitBase;
+    Stream.BackpatchBits(IndexOffsetPlaceholder, uint32_t(IndexOffset));
+    Stream.BackpatchBits(IndexOffsetPlaceholder + 32,
+                         uint32_t(IndexOffset >> 32));
+    WriteFunctionIndex(FunctionBits, Stream);
+  }
 
   Stream.ExitBlock();
 }
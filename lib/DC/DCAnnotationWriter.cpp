@@ -8,19 +8,62 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/DC/DCAnnotationWriter.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/MC/MCAnalysis/MCFunction.h"
 #include "llvm/MC/MCInstPrinter.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/Support/FormattedStream.h"
+#include <algorithm>
 
 using namespace llvm;
 
 DCAnnotationWriter::DCAnnotationWriter(const DCTranslatedInstTracker &DTIT,
                                        const MCRegisterInfo &MRI,
                                        MCInstPrinter &IP,
-                                       const MCSubtargetInfo &STI)
-    : AssemblyAnnotationWriter(), DTIT(DTIT), MRI(MRI), IP(IP), STI(STI) {}
+                                       const MCSubtargetInfo &STI,
+                                       AnnotationFormat Format)
+    : AssemblyAnnotationWriter(), DTIT(DTIT), MRI(MRI), IP(IP), STI(STI),
+      Format(Format), LastMCDI(0) {}
+
+StringRef DCAnnotationWriter::getInstText(const MCDecodedInst &MCDI) {
+  StringRef &Text = InstText[&MCDI];
+  if (Text.data())
+    return Text;
+
+  SmallString<64> Buf;
+  raw_svector_ostream OS(Buf);
+  IP.printInst(&MCDI.Inst, OS, "", STI);
+  char *Mem = InstTextAllocator.Allocate<char>(Buf.size());
+  std::copy(Buf.begin(), Buf.end(), Mem);
+  Text = StringRef(Mem, Buf.size());
+  return Text;
+}
+
+void DCAnnotationWriter::writeInstTable(raw_ostream &OS) const {
+  std::vector<std::pair<uint64_t, StringRef>> Table;
+  Table.reserve(InstText.size());
+  for (const auto &I : InstText)
+    Table.push_back(std::make_pair(I.first->Address, I.second));
+  std::sort(Table.begin(), Table.end());
+  // The same instruction can be decoded more than once, for instance when a
+  // basic block is shared by different functions.
+  Table.erase(std::unique(Table.begin(), Table.end()), Table.end());
+  for (const auto &Entry : Table) {
+    OS.write_hex(Entry.first);
+    OS << '\t' << Entry.second.ltrim() << '\n';
+  }
+}
+
+void DCAnnotationWriter::emitFunctionAnnot(const Function *,
+                                           formatted_raw_ostream &) {
+  LastMCDI = 0;
+}
+
+void DCAnnotationWriter::emitBasicBlockStartAnnot(const BasicBlock *,
+                                                  formatted_raw_ostream &) {
+  LastMCDI = 0;
+}
 
 void DCAnnotationWriter::printInfoComment(const Value &V,
                                           formatted_raw_ostream &OS) {
@@ -93,13 +136,24 @@ void DCAnnotationWriter::printInfoComment(const Value &V,
       OS.PadToColumn(72);
       OS << " MO#" << VI.MIOperandNo;
     }
+    // Only print the instruction once per group of values coming from it.
+    if (Format == Compact && MCDI == LastMCDI)
+      continue;
+    LastMCDI = MCDI;
+
     OS.PadToColumn(79);
     OS << " @";
     OS.write_hex(Addr);
 
-    if (MCDI)
-      OS << ": ";
-    IP.printInst(&MCDI->Inst, OS.PadToColumn(90), "", STI);
+    if (!MCDI)
+      continue;
+    // The text goes to the sidecar table; just make sure it's in there.
+    if (Format == AddressOnly) {
+      getInstText(*MCDI);
+      continue;
+    }
+    OS << ": ";
+    OS.PadToColumn(90) << getInstText(*MCDI);
   }
 }
 
@@ -9,8 +9,10 @@
 
 #include "llvm/DC/DCInstrSema.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/CodeGen/ISDOpcodes.h"
+#include "llvm/DC/DCReadOnlyImage.h"
 #include "llvm/DC/DCRegisterSema.h"
 #include "llvm/DC/DCTranslatedInstTracker.h"
 #include "llvm/IR/BasicBlock.h"
@@ -24,6 +26,7 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/IR/Type.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCAnalysis/MCFunction.h"
@@ -33,6 +36,8 @@ using namespace llvm;
 
 #define DEBUG_TYPE "dc-sema"
 
+STATISTIC(NumReadOnlyLoadsFolded, "Number of loads from read-only data folded");
+
 static cl::opt<bool>
 EnableRegSetDiff("enable-dc-regset-diff", cl::desc(""), cl::init(false));
 
@@ -43,7 +48,7 @@ DCInstrSema::DCInstrSema(const unsigned *OpcodeToSemaIdx,
                          const unsigned *SemanticsArray,
                          const uint64_t *ConstantArray, DCRegisterSema &DRS)
     : OpcodeToSemaIdx(OpcodeToSemaIdx), SemanticsArray(SemanticsArray),
-      ConstantArray(ConstantArray), DynTranslateAtCBPtr(0),
+      ConstantArray(ConstantArray), DynTranslateAtCBPtr(0), ROImage(0),
       Ctx(0), TheModule(0), DRS(DRS), FuncType(0),
       TheFunction(0), TheMCFunction(0), BBByAddr(), ExitBB(0), CallBBs(),
       TheBB(0), TheMCBB(0), Builder(), Idx(0), ResEVT(), Opcode(0), Vals(),
@@ -60,14 +65,46 @@ Function *DCInstrSema::FinalizeFunction() {
     DRS.restoreLocalRegs(CallBB, ++CallI);
   }
   DRS.FinalizeFunction(ExitBB);
+  annotateGuestMemoryAccesses();
   CallBBs.clear();
   BBByAddr.clear();
+  // See DCRegisterSema::FinalizeFunction.
+  Builder->ClearInsertionPoint();
   Function *Fn = TheFunction;
   TheFunction = nullptr;
   TheMCFunction = nullptr;
   return Fn;
 }
 
+void DCInstrSema::annotateGuestMemoryAccesses() {
+  // Guest memory is only ever accessed through an inttoptr of a guest
+  // address, be it from the generic LOAD/STORE semantics or from the target's
+  // custom translations. The regset accesses were tagged by DRS.
+  // Volatile accesses are DC's own instrumentation, to host memory.
+  MDNode *Tag = DRS.getGuestMemTBAATag();
+  for (BasicBlock &BB : *TheFunction) {
+    for (Instruction &I : BB) {
+      Value *Ptr;
+      if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+        if (LI->isVolatile())
+          continue;
+        Ptr = LI->getPointerOperand();
+      } else if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+        if (SI->isVolatile())
+          continue;
+        Ptr = SI->getPointerOperand();
+      } else {
+        continue;
+      }
+      if (I.getMetadata(LLVMContext::MD_tbaa))
+        continue;
+      if (Operator::getOpcode(Ptr->stripPointerCasts()) ==
+          Instruction::IntToPtr)
+        I.setMetadata(LLVMContext::MD_tbaa, Tag);
+    }
+  }
+}
+
 void DCInstrSema::FinalizeBasicBlock() {
   if (!TheBB->getTerminator())
     BranchInst::Create(getOrCreateBasicBlock(getBasicBlockEndAddress()),
@@ -347,6 +384,55 @@ void DCInstrSema::insertCall(Value *CallTarget) {
   insertCallBB(CallTarget);
 }
 
+// Evaluate \p V, built by the NoFolder Builder, as a constant expression.
+static Constant *evaluateConstant(Value *V, unsigned Depth = 0) {
+  if (Constant *C = dyn_cast<Constant>(V))
+    return C;
+  if (Depth == 16)
+    return nullptr;
+  if (BinaryOperator *BO = dyn_cast<BinaryOperator>(V)) {
+    Constant *LHS = evaluateConstant(BO->getOperand(0), Depth + 1);
+    if (!LHS)
+      return nullptr;
+    Constant *RHS = evaluateConstant(BO->getOperand(1), Depth + 1);
+    if (!RHS)
+      return nullptr;
+    return ConstantExpr::get(BO->getOpcode(), LHS, RHS);
+  }
+  if (CastInst *CI = dyn_cast<CastInst>(V)) {
+    if (Constant *Op = evaluateConstant(CI->getOperand(0), Depth + 1))
+      return ConstantExpr::getCast(CI->getOpcode(), Op, CI->getType());
+  }
+  return nullptr;
+}
+
+Value *DCInstrSema::foldReadOnlyLoad(Value *Addr, Type *ResType) {
+  if (!ROImage)
+    return nullptr;
+  if (!ResType->isIntegerTy() && !ResType->isFloatTy() &&
+      !ResType->isDoubleTy())
+    return nullptr;
+  unsigned SizeInBits = ResType->getPrimitiveSizeInBits();
+  if (SizeInBits % 8 || SizeInBits > 64)
+    return nullptr;
+
+  // Target memory operands usually come already cast to a pointer.
+  if (IntToPtrInst *ITP = dyn_cast<IntToPtrInst>(Addr))
+    Addr = ITP->getOperand(0);
+  ConstantInt *CstAddr = dyn_cast_or_null<ConstantInt>(evaluateConstant(Addr));
+  if (!CstAddr || CstAddr->getBitWidth() > 64)
+    return nullptr;
+  uint64_t Val;
+  if (!ROImage->read(CstAddr->getZExtValue(), SizeInBits / 8, Val))
+    return nullptr;
+
+  ++NumReadOnlyLoadsFolded;
+  Constant *C = ConstantInt::get(IntegerType::get(*Ctx, SizeInBits), Val);
+  if (!ResType->isIntegerTy())
+    C = ConstantExpr::getBitCast(C, ResType);
+  return C;
+}
+
 void DCInstrSema::translateBinOp(Instruction::BinaryOps Opc) {
   Value *V1 = getNextOperand();
   Value *V2 = getNextOperand();
@@ -508,6 +594,10 @@ void DCInstrSema::translateOpcode(unsigned Opcode) {
       } else {
           ResType = ResEVT.getTypeForEVT(*Ctx);
       }
+    if (Value *Folded = foldReadOnlyLoad(Ptr, ResType)) {
+      registerResult(Folded);
+      break;
+    }
     if (!Ptr->getType()->isPointerTy())
       Ptr = Builder->CreateIntToPtr(Ptr, ResType->getPointerTo());
     assert(Ptr->getType()->getPointerElementType() == ResType &&
@@ -0,0 +1,143 @@
+//===-- lib/DC/DCReadOnlyImage.cpp - DC Read-only Image View ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DC/DCReadOnlyImage.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Object/MachO.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace object;
+
+std::unique_ptr<DCReadOnlyImage>
+DCReadOnlyImage::create(const ObjectFile &Obj) {
+  std::unique_ptr<DCReadOnlyImage> Image(
+      new DCReadOnlyImage(Obj.isLittleEndian()));
+  if (const MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(&Obj))
+    Image->addMachO(*MachO);
+  Image->finalize();
+  return Image;
+}
+
+static bool isImmutableSegment(StringRef Name, uint32_t InitProt) {
+  // __DATA_CONST is mapped writable so that dyld can apply its fixups; what
+  // is left after excluding those is immutable.
+  // Relocatable objects have a single, anonymous, RWX segment: fall back to
+  // the segment name the sections will end up in.
+  return !(InitProt & MachO::VM_PROT_WRITE) || Name == "__TEXT" ||
+         Name == "__DATA_CONST";
+}
+
+void DCReadOnlyImage::addMachO(const MachOObjectFile &MachO) {
+  // Segments, in load command order, as indexed by the rebase/bind tables.
+  ArrayRef<MachOObjectFile::SegmentInfo> Segments = MachO.segments();
+
+  for (const SectionRef &Section : MachO.sections()) {
+    if (Section.isBSS() || !Section.getSize())
+      continue;
+    DataRefImpl DRI = Section.getRawDataRefImpl();
+    uint64_t Addr = Section.getAddress();
+
+    // Protection comes from the containing segment, unless the object is
+    // relocatable, in which case only the final segment name is meaningful.
+    uint32_t InitProt = MachO::VM_PROT_WRITE;
+    if (MachO.getHeader().filetype != MachO::MH_OBJECT)
+      if (const auto *Seg = MachO.findSegmentContaining(Addr))
+        InitProt = Seg->InitProt;
+    if (!isImmutableSegment(MachO.getSectionFinalSegmentName(DRI), InitProt))
+      continue;
+
+    StringRef Contents;
+    if (Section.getContents(Contents))
+      continue;
+    Range R;
+    R.Begin = Addr;
+    R.End = Addr + Contents.size();
+    R.Contents = Contents;
+    Ranges.push_back(R);
+
+    // Relocatable objects are patched by the linker.
+    for (const RelocationRef &Reloc : Section.relocations()) {
+      MachO::any_relocation_info RE =
+          MachO.getRelocation(Reloc.getRawDataRefImpl());
+      addExcluded(Addr + Reloc.getOffset(),
+                  1ULL << MachO.getAnyRelocationLength(RE));
+    }
+  }
+
+  // Linked images are patched by dyld.
+  const uint64_t PtrSize = MachO.is64Bit() ? 8 : 4;
+  auto SegmentAddress = [&](uint32_t SegIdx, uint64_t SegOffset) {
+    if (SegIdx >= Segments.size())
+      return uint64_t(0);
+    return Segments[SegIdx].VMAddr + SegOffset;
+  };
+  for (const MachORebaseEntry &Entry : MachO.rebaseTable())
+    addExcluded(SegmentAddress(Entry.segmentIndex(), Entry.segmentOffset()),
+                PtrSize);
+  for (const MachOBindEntry &Entry : MachO.bindTable())
+    addExcluded(SegmentAddress(Entry.segmentIndex(), Entry.segmentOffset()),
+                PtrSize);
+  for (const MachOBindEntry &Entry : MachO.lazyBindTable())
+    addExcluded(SegmentAddress(Entry.segmentIndex(), Entry.segmentOffset()),
+                PtrSize);
+  for (const MachOBindEntry &Entry : MachO.weakBindTable())
+    addExcluded(SegmentAddress(Entry.segmentIndex(), Entry.segmentOffset()),
+                PtrSize);
+}
+
+void DCReadOnlyImage::finalize() {
+  std::sort(Ranges.begin(), Ranges.end());
+
+  // Merge the excluded ranges, so that a single lookup is enough.
+  std::sort(Excluded.begin(), Excluded.end());
+  size_t Out = 0;
+  for (size_t i = 0, e = Excluded.size(); i != e; ++i) {
+    if (Out && Excluded[i].first <= Excluded[Out - 1].second)
+      Excluded[Out - 1].second =
+          std::max(Excluded[Out - 1].second, Excluded[i].second);
+    else
+      Excluded[Out++] = Excluded[i];
+  }
+  Excluded.resize(Out);
+}
+
+bool DCReadOnlyImage::read(uint64_t Addr, unsigned Size, uint64_t &Val) const {
+  if (Size == 0 || Size > 8 || Addr + Size < Addr)
+    return false;
+
+  // Find the last range that begins at or before Addr.
+  auto RI = std::upper_bound(
+      Ranges.begin(), Ranges.end(), Addr,
+      [](uint64_t A, const Range &R) { return A < R.Begin; });
+  if (RI == Ranges.begin())
+    return false;
+  --RI;
+  if (Addr + Size > RI->End)
+    return false;
+
+  // Find the first excluded range that ends after Addr.
+  auto EI = std::upper_bound(
+      Excluded.begin(), Excluded.end(), Addr,
+      [](uint64_t A, const std::pair<uint64_t, uint64_t> &E) {
+        return A < E.second;
+      });
+  if (EI != Excluded.end() && EI->first < Addr + Size)
+    return false;
+
+  const uint8_t *Bytes =
+      reinterpret_cast<const uint8_t *>(RI->Contents.data()) +
+      (Addr - RI->Begin);
+  Val = 0;
+  for (unsigned i = 0; i != Size; ++i) {
+    unsigned Shift = IsLittleEndian ? i * 8 : (Size - 1 - i) * 8;
+    Val |= uint64_t(Bytes[i]) << Shift;
+  }
+  return true;
+}
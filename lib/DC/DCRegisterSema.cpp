@@ -12,6 +12,7 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/MC/MCRegisterInfo.h"
@@ -31,7 +32,7 @@ DCRegisterSema::DCRegisterSema(const MCRegisterInfo &MRI,
     : MRI(MRI), MII(MII), DL(DL), NumRegs(MRI.getNumRegs()), NumLargest(0),
       RegSizes(NumRegs), RegLargestSupers(NumRegs),
       RegOffsetsInSet(NumRegs, -1), LargestRegs(), TheModule(0), Ctx(0),
-      RegSetType(0), Builder(), RegPtrs(NumRegs), RegAllocas(NumRegs),
+      RegSetType(0), RegSetTBAATag(0), GuestMemTBAATag(0), Builder(), RegPtrs(NumRegs), RegAllocas(NumRegs),
       RegInits(NumRegs), RegAssignments(NumRegs), TheFunction(0),
       RegVals(NumRegs), CurrentInst(0) {
 
@@ -95,6 +96,13 @@ void DCRegisterSema::SwitchToModule(Module *Mod) {
     LargestRegTypes[I - 1] = getRegType(LargestRegs[I]);
 
   RegSetType = StructType::create(LargestRegTypes, "regset");
+
+  MDBuilder MDB(*Ctx);
+  MDNode *Root = MDB.createTBAARoot("DC TBAA");
+  MDNode *RegSetTy = MDB.createTBAAScalarTypeNode("regset", Root);
+  MDNode *GuestMemTy = MDB.createTBAAScalarTypeNode("guest-mem", Root);
+  RegSetTBAATag = MDB.createTBAAStructTagNode(RegSetTy, RegSetTy, 0);
+  GuestMemTBAATag = MDB.createTBAAStructTagNode(GuestMemTy, GuestMemTy, 0);
 }
 
 void DCRegisterSema::SwitchToFunction(Function *Fn) { TheFunction = Fn; }
@@ -125,7 +133,8 @@ void DCRegisterSema::saveAllLocalRegs(BasicBlock *BB, BasicBlock::iterator IP) {
     int OffsetInSet = RegOffsetsInSet[RI];
     if (OffsetInSet != -1)
       LocalBuilder.CreateStore(LocalBuilder.CreateLoad(RegAllocas[RI]),
-                               RegPtrs[RI]);
+                               RegPtrs[RI])
+          ->setMetadata(LLVMContext::MD_tbaa, RegSetTBAATag);
   }
 }
 
@@ -142,8 +151,11 @@ void DCRegisterSema::restoreLocalRegs(BasicBlock *BB, BasicBlock::iterator IP) {
         }
     }
     int OffsetInSet = RegOffsetsInSet[RI];
-    if (OffsetInSet != -1)
-      setReg(RI, Builder->CreateLoad(RegPtrs[RI]));
+    if (OffsetInSet != -1) {
+      LoadInst *RV = Builder->CreateLoad(RegPtrs[RI]);
+      RV->setMetadata(LLVMContext::MD_tbaa, RegSetTBAATag);
+      setReg(RI, RV);
+    }
   }
   FinalizeBasicBlock();
 }
@@ -156,6 +168,10 @@ void DCRegisterSema::FinalizeFunction(BasicBlock *ExitBB) {
     RegPtrs[RI] = 0;
     RegInits[RI] = 0;
   }
+
+  // The function is about to be optimized, which can delete the block we
+  // were inserting into.
+  Builder->ClearInsertionPoint();
 }
 
 void DCRegisterSema::FinalizeBasicBlock() {
@@ -238,6 +254,7 @@ void DCRegisterSema::createLocalValueForReg(unsigned RegNo) {
     RP = Builder->CreateInBoundsGEP(RegSetArg, Idx);
     RP->setName((RegName + "_ptr").str());
     RI = Builder->CreateLoad(RP);
+    cast<LoadInst>(RI)->setMetadata(LLVMContext::MD_tbaa, RegSetTBAATag);
   }
   RI->setName((RegName + "_init").str());
   // Then, create an alloca for the register.
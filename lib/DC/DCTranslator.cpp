@@ -10,12 +10,17 @@
 #include "llvm/DC/DCTranslator.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/TypeBasedAliasAnalysis.h"
 #include "llvm/DC/DCInstrSema.h"
 #include "llvm/DC/DCRegisterSema.h"
+#include "llvm/InitializePasses.h"
 #include "llvm/MC/MCAnalysis/MCFunction.h"
 #include "llvm/MC/MCAnalysis/MCModule.h"
 #include "llvm/MC/MCObjectDisassembler.h"
 #include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/raw_ostream.h"
@@ -45,6 +50,17 @@ class NonVolatileRegistersPass : public FunctionPass {
 using namespace llvm;
 
 char NonVolatileRegistersPass::ID = 0;
+static RegisterPass<NonVolatileRegistersPass>
+X("dc-nonvolatile-regs", "DC: Forward non-volatile register stores across "
+                         "calls");
+
+static cl::opt<std::string>
+TranslationPasses("dc-passes",
+                  cl::desc("Comma-separated list of the passes to run on "
+                           "each translated function, replacing the "
+                           "TransOpt level pipeline (e.g. "
+                           "'dc-nonvolatile-regs,sroa,early-cse,dse')"),
+                  cl::init(""));
 
 bool NonVolatileRegistersPass::runOnFunction(Function &F) {
 
@@ -191,23 +207,54 @@ Module *DCTranslator::finalizeTranslationModule() {
   CurrentModule->setDataLayout(DL);
 
   CurrentFPM.reset(new legacy::FunctionPassManager(CurrentModule));
+  addTranslationPasses(*CurrentFPM);
 
-  if (OptLevel >= TransOpt::Less) {
-    CurrentFPM->add(new NonVolatileRegistersPass());
-    CurrentFPM->add(createInstructionCombiningPass());
-    CurrentFPM->add(createSROAPass());
-//    CurrentFPM->add(createCFGSimplificationPass());
-//    CurrentFPM->add(createConstantPropagationPass());
+  DIS.SwitchToModule(CurrentModule);
+  return OldModule;
+}
 
-//    CurrentFPM->add(createPromoteMemoryToRegisterPass());
+void DCTranslator::addTranslationPasses(legacy::FunctionPassManager &FPM) {
+  if (!TranslationPasses.empty()) {
+    PassRegistry &Registry = *PassRegistry::getPassRegistry();
+    initializeCore(Registry);
+    initializeScalarOpts(Registry);
+    initializeInstCombine(Registry);
+    initializeAnalysis(Registry);
+    initializeTransformUtils(Registry);
+
+    SmallVector<StringRef, 8> Names;
+    StringRef(TranslationPasses).split(Names, ",", -1, false);
+    for (StringRef Name : Names) {
+      const PassInfo *PI = Registry.getPassInfo(Name.trim());
+      if (!PI || !PI->getNormalCtor())
+        report_fatal_error("DC: unknown pass '" + Name + "' in -dc-passes");
+      FPM.add(PI->createPass());
+    }
+    return;
   }
-  if (OptLevel >= TransOpt::Default)
-    CurrentFPM->add(createDeadCodeEliminationPass());
-  if (OptLevel >= TransOpt::Aggressive)
-    CurrentFPM->add(createInstructionCombiningPass());
 
-  DIS.SwitchToModule(CurrentModule);
-  return OldModule;
+  // The translated IR accesses registers through allocas that are loaded and
+  // stored around every call, and has placeholder blocks for the addresses
+  // that weren't reached.
+  if (OptLevel >= TransOpt::Less) {
+    // Use the regset/guest-mem TBAA tags, see DCRegisterSema.
+    FPM.add(createTypeBasedAliasAnalysisPass());
+    FPM.add(createBasicAliasAnalysisPass());
+    FPM.add(new NonVolatileRegistersPass());
+    FPM.add(createSROAPass());
+    FPM.add(createEarlyCSEPass());
+    FPM.add(createInstructionCombiningPass());
+  }
+  if (OptLevel >= TransOpt::Default) {
+    FPM.add(createDeadStoreEliminationPass());
+    FPM.add(createCFGSimplificationPass());
+    FPM.add(createDeadCodeEliminationPass());
+  }
+  if (OptLevel >= TransOpt::Aggressive) {
+    FPM.add(createGVNPass());
+    FPM.add(createInstructionCombiningPass());
+    FPM.add(createCFGSimplificationPass());
+  }
 }
 
 void DCTranslator::translateAllKnownFunctions() {
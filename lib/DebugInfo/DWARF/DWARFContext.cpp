@@ -294,8 +294,11 @@ const DWARFDebugLocDWO *DWARFContext::getDebugLocDWO() {
 }
 
 const DWARFDebugAranges *DWARFContext::getDebugAranges() {
-  if (Aranges)
+  if (Aranges) {
+    // getCompileUnitForAddress may have only built it from .debug_aranges.
+    Aranges->addUnitsWithoutAranges(this);
     return Aranges.get();
+  }
 
   Aranges.reset(new DWARFDebugAranges());
   Aranges->generate(this);
@@ -324,6 +327,10 @@ const DWARFDebugFrame *DWARFContext::getDebugFrame() {
 
 const DWARFLineTable *
 DWARFContext::getLineTableForUnit(DWARFUnit *U) {
+  auto UI = UnitLineTables.find(U);
+  if (UI != UnitLineTables.end())
+    return UI->second;
+
   if (!Line)
     Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
   const auto *UnitDIE = U->getUnitDIE();
@@ -332,16 +339,16 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   unsigned stmtOffset =
       UnitDIE->getAttributeValueAsSectionOffset(U, DW_AT_stmt_list, -1U);
   if (stmtOffset == -1U)
-    return nullptr; // No line table for this compile unit.
+    return UnitLineTables[U] = nullptr; // No line table for this compile unit.
 
   // See if the line table is cached.
   if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
-    return lt;
+    return UnitLineTables[U] = lt;
 
   // We have to parse it first.
   DataExtractor lineData(getLineSection().Data, isLittleEndian(),
                          U->getAddressByteSize());
-  return Line->getOrParseLineTable(lineData, stmtOffset);
+  return UnitLineTables[U] = Line->getOrParseLineTable(lineData, stmtOffset);
 }
 
 void DWARFContext::parseCompileUnits() {
@@ -376,8 +383,16 @@ DWARFCompileUnit *DWARFContext::getCompileUnitForOffset(uint32_t Offset) {
 }
 
 DWARFCompileUnit *DWARFContext::getCompileUnitForAddress(uint64_t Address) {
-  // First, get the offset of the compile unit.
-  uint32_t CUOffset = getDebugAranges()->findAddress(Address);
+  // First, get the offset of the compile unit. The index is built from
+  // .debug_aranges alone at first; the DIEs of the units that section doesn't
+  // describe are only parsed once an address isn't found in it.
+  if (!Aranges) {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generateFromSection(this);
+  }
+  uint32_t CUOffset = Aranges->findAddress(Address);
+  if (CUOffset == -1U && Aranges->addUnitsWithoutAranges(this))
+    CUOffset = Aranges->findAddress(Address);
   // Retrieve the compile unit.
   return getCompileUnitForOffset(CUOffset);
 }
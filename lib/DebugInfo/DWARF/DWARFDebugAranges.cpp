@@ -47,6 +47,31 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
+  appendUnitsWithoutAranges(CTX);
+
+  construct();
+}
+
+void DWARFDebugAranges::generateFromSection(DWARFContext *CTX) {
+  clear();
+  if (!CTX)
+    return;
+
+  DataExtractor ArangesData(CTX->getARangeSection(), CTX->isLittleEndian(), 0);
+  extract(ArangesData);
+  construct(/*KeepEndpoints=*/true);
+}
+
+bool DWARFDebugAranges::addUnitsWithoutAranges(DWARFContext *CTX) {
+  if (!CTX || HasAllUnits)
+    return false;
+  appendUnitsWithoutAranges(CTX);
+  Aranges.clear();
+  construct();
+  return true;
+}
+
+void DWARFDebugAranges::appendUnitsWithoutAranges(DWARFContext *CTX) {
   for (const auto &CU : CTX->compile_units()) {
     uint32_t CUOffset = CU->getOffset();
     if (ParsedCUOffsets.insert(CUOffset).second) {
@@ -57,14 +82,14 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
       }
     }
   }
-
-  construct();
+  HasAllUnits = true;
 }
 
 void DWARFDebugAranges::clear() {
   Endpoints.clear();
   Aranges.clear();
   ParsedCUOffsets.clear();
+  HasAllUnits = false;
 }
 
 void DWARFDebugAranges::appendRange(uint32_t CUOffset, uint64_t LowPC,
@@ -75,7 +100,7 @@ void DWARFDebugAranges::appendRange(uint32_t CUOffset, uint64_t LowPC,
   Endpoints.emplace_back(HighPC, CUOffset, false);
 }
 
-void DWARFDebugAranges::construct() {
+void DWARFDebugAranges::construct(bool KeepEndpoints) {
   std::multiset<uint32_t> ValidCUs;  // Maintain the set of CUs describing
                                      // a current address range.
   std::sort(Endpoints.begin(), Endpoints.end());
@@ -104,7 +129,9 @@ void DWARFDebugAranges::construct() {
   }
   assert(ValidCUs.empty());
 
-  // Endpoints are not needed now.
+  // Endpoints are not needed now, unless more ranges are to be added.
+  if (KeepEndpoints)
+    return;
   std::vector<RangeEndpoint> EmptyEndpoints;
   EmptyEndpoints.swap(Endpoints);
 }
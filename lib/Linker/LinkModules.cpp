@@ -1771,6 +1771,181 @@ void Linker::setModule(Module *Dst) {
   init(Dst, DiagnosticHandler);
 }
 
+//===----------------------------------------------------------------------===//
+// Disjoint shard linking.
+//===----------------------------------------------------------------------===//
+
+namespace {
+enum class ShardKind {
+  Movable,    ///< Can be moved into the composite as is.
+  NeedsMap,   ///< Must be mapped by the regular linker.
+  Conflicting ///< Redefines a symbol of the composite.
+};
+}
+
+static bool hasStrongDefinition(const GlobalValue &GV) {
+  return !GV.isDeclaration() && !GV.hasLocalLinkage() &&
+         !GV.isWeakForLinker() && !GV.hasAvailableExternallyLinkage();
+}
+
+/// Return the global value of \p Dst that \p SGV links to, if any.
+static GlobalValue *getLinkedToGlobal(Module &Dst, const GlobalValue &SGV) {
+  if (!SGV.hasName() || SGV.hasLocalLinkage())
+    return nullptr;
+  GlobalValue *DGV = Dst.getNamedValue(SGV.getName());
+  if (!DGV || DGV->hasLocalLinkage())
+    return nullptr;
+  return DGV;
+}
+
+/// Figure out whether \p Src can be moved wholesale into \p Dst.
+static ShardKind classifyShard(Module &Dst, Module &Src,
+                               Linker::IdentifiedStructTypeSet &Types,
+                               const GlobalValue *&Conflict) {
+  // Anything that needs merging rather than moving.
+  if (!Src.alias_empty() || !Src.getComdatSymbolTable().empty() ||
+      !Src.getModuleInlineAsm().empty())
+    return ShardKind::NeedsMap;
+  for (const GlobalVariable &GV : Src.globals())
+    if (GV.hasAppendingLinkage())
+      return ShardKind::NeedsMap;
+
+  bool DstIsEmpty = Dst.empty() && Dst.global_empty();
+  if (!DstIsEmpty && (Src.getDataLayout() != Dst.getDataLayout() ||
+                      Src.getTargetTriple() != Dst.getTargetTriple()))
+    return ShardKind::NeedsMap;
+
+  // Module flags are not merged: they have to be the same in all the shards.
+  const NamedMDNode *SrcFlags = Src.getModuleFlagsMetadata();
+  const NamedMDNode *DstFlags = Dst.getModuleFlagsMetadata();
+  if (SrcFlags && DstFlags && SrcFlags->getNumOperands() &&
+      DstFlags->getNumOperands()) {
+    if (SrcFlags->getNumOperands() != DstFlags->getNumOperands())
+      return ShardKind::NeedsMap;
+    for (unsigned I = 0, E = SrcFlags->getNumOperands(); I != E; ++I)
+      if (SrcFlags->getOperand(I) != DstFlags->getOperand(I))
+        return ShardKind::NeedsMap;
+  }
+
+  // The struct types must be either shared with the composite, or new to it.
+  TypeFinder SrcTypes;
+  SrcTypes.run(Src, false);
+  for (StructType *Ty : SrcTypes) {
+    if (Ty->isLiteral() || Types.hasType(Ty))
+      continue;
+    if (Ty->isOpaque() || Types.findNonOpaque(Ty->elements(), Ty->isPacked()))
+      return ShardKind::NeedsMap;
+  }
+
+  // Only declarations may be resolved across shards.
+  auto Classify = [&](const GlobalValue &SGV) {
+    const GlobalValue *DGV = getLinkedToGlobal(Dst, SGV);
+    if (!DGV || SGV.isDeclaration() || DGV->isDeclaration())
+      return ShardKind::Movable;
+    if (hasStrongDefinition(SGV) && hasStrongDefinition(*DGV)) {
+      Conflict = &SGV;
+      return ShardKind::Conflicting;
+    }
+    return ShardKind::NeedsMap;
+  };
+  for (const GlobalVariable &GV : Src.globals()) {
+    ShardKind K = Classify(GV);
+    if (K != ShardKind::Movable)
+      return K;
+  }
+  for (const Function &F : Src) {
+    ShardKind K = Classify(F);
+    if (K != ShardKind::Movable)
+      return K;
+  }
+  return ShardKind::Movable;
+}
+
+bool Linker::linkDisjointShard(Module *Src) {
+  if (std::error_code EC = Src->materializeAllPermanently()) {
+    DiagnosticHandler(LinkDiagnosticInfo(DS_Error, EC.message()));
+    return true;
+  }
+
+  const GlobalValue *Conflict = nullptr;
+  switch (classifyShard(*Composite, *Src, IdentifiedStructTypes, Conflict)) {
+  case ShardKind::NeedsMap:
+    return linkInModule(Src);
+  case ShardKind::Conflicting:
+    DiagnosticHandler(LinkDiagnosticInfo(
+        DS_Error, "Linking disjoint shards: symbol '" + Conflict->getName() +
+                      "' is defined in more than one shard"));
+    return true;
+  case ShardKind::Movable:
+    break;
+  }
+
+  if (Composite->getDataLayout().isDefault())
+    Composite->setDataLayout(Src->getDataLayout());
+  if (Composite->getTargetTriple().empty())
+    Composite->setTargetTriple(Src->getTargetTriple());
+
+  // The struct types the shard brings in are now part of the composite.
+  TypeFinder SrcTypes;
+  SrcTypes.run(*Src, false);
+  for (StructType *Ty : SrcTypes)
+    if (!Ty->isLiteral() && !IdentifiedStructTypes.hasType(Ty))
+      IdentifiedStructTypes.addNonOpaque(Ty);
+
+  // Move the global values over. A declaration already known to the
+  // composite is replaced by the composite's symbol, and a declaration of
+  // the composite that the shard defines is replaced by the definition.
+  std::vector<GlobalValue *> SrcGVs;
+  for (GlobalVariable &GV : Src->globals())
+    SrcGVs.push_back(&GV);
+  for (Function &F : *Src)
+    SrcGVs.push_back(&F);
+
+  for (GlobalValue *SGV : SrcGVs) {
+    GlobalValue *DGV = getLinkedToGlobal(*Composite, *SGV);
+    if (DGV && SGV->isDeclaration()) {
+      SGV->replaceAllUsesWith(ConstantExpr::getBitCast(DGV, SGV->getType()));
+      SGV->eraseFromParent();
+      continue;
+    }
+
+    if (auto *F = dyn_cast<Function>(SGV))
+      Composite->getFunctionList().splice(Composite->end(),
+                                          Src->getFunctionList(), F);
+    else
+      Composite->getGlobalList().splice(Composite->global_end(),
+                                        Src->getGlobalList(),
+                                        cast<GlobalVariable>(SGV));
+
+    if (DGV) {
+      // The move renamed SGV, as DGV still holds its name.
+      DGV->replaceAllUsesWith(ConstantExpr::getBitCast(SGV, DGV->getType()));
+      SGV->takeName(DGV);
+      DGV->eraseFromParent();
+    }
+  }
+
+  // The metadata is already in the right context: only the named nodes need
+  // to be merged.
+  for (NamedMDNode &SrcNMD : Src->named_metadata()) {
+    NamedMDNode *DstNMD = Composite->getOrInsertNamedMetadata(SrcNMD.getName());
+    if (&SrcNMD == Src->getModuleFlagsMetadata() && DstNMD->getNumOperands())
+      continue;
+    for (unsigned I = 0, E = SrcNMD.getNumOperands(); I != E; ++I)
+      DstNMD->addOperand(SrcNMD.getOperand(I));
+  }
+
+  Composite->dropTriviallyDeadConstantArrays();
+  return false;
+}
+
+bool Linker::linkDisjointShards(ArrayRef<Module *> Shards) {
+  for (Module *Src : Shards)
+    if (linkDisjointShard(Src))
+      return true;
+  return false;
+}
+
 //===----------------------------------------------------------------------===//
 // LinkModules entrypoint.
 //===----------------------------------------------------------------------===//
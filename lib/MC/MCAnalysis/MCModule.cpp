@@ -28,7 +28,48 @@ MCFunction *MCModule::findFunctionAt(uint64_t BeginAddr) {
   return FnIt->second;
 }
 
-MCModule::MCModule() {}
+void MCModule::addSymbolicOperand(uint64_t InstAddr, uint64_t TargetAddr,
+                                  uint32_t SymbolIdx, uint32_t OpIdx) {
+  SymbolicOperand SO = {InstAddr, TargetAddr, SymbolIdx, OpIdx};
+  SymbolicOperands.push_back(SO);
+  SymbolicOperandsSorted = false;
+}
+
+static bool SymbolicOperandLess(const MCModule::SymbolicOperand &LHS,
+                                const MCModule::SymbolicOperand &RHS) {
+  if (LHS.InstAddr != RHS.InstAddr)
+    return LHS.InstAddr < RHS.InstAddr;
+  return LHS.OpIdx < RHS.OpIdx;
+}
+
+ArrayRef<MCModule::SymbolicOperand>
+MCModule::getSymbolicOperands(uint64_t InstAddr) const {
+  if (!SymbolicOperandsSorted) {
+    // An instruction can be disassembled more than once (e.g., when a basic
+    // block is split); only keep the first recording of each operand.
+    std::stable_sort(SymbolicOperands.begin(), SymbolicOperands.end(),
+                     SymbolicOperandLess);
+    SymbolicOperands.erase(
+        std::unique(SymbolicOperands.begin(), SymbolicOperands.end(),
+                    [](const SymbolicOperand &LHS, const SymbolicOperand &RHS) {
+                      return LHS.InstAddr == RHS.InstAddr &&
+                             LHS.OpIdx == RHS.OpIdx;
+                    }),
+        SymbolicOperands.end());
+    SymbolicOperandsSorted = true;
+  }
+  SymbolicOperand Key = {InstAddr, 0, 0, 0};
+  auto Range = std::equal_range(
+      SymbolicOperands.begin(), SymbolicOperands.end(), Key,
+      [](const SymbolicOperand &LHS, const SymbolicOperand &RHS) {
+        return LHS.InstAddr < RHS.InstAddr;
+      });
+  return makeArrayRef(SymbolicOperands.data() +
+                          (Range.first - SymbolicOperands.begin()),
+                      Range.second - Range.first);
+}
+
+MCModule::MCModule() : SymbolicOperandsSorted(true) {}
 
 MCModule::~MCModule() {
 }
@@ -50,13 +50,13 @@ MCObjectDisassembler::getRegionFor(uint64_t Addr) {
         for (std::vector<MemoryRegion>::iterator it = SectionRegions.begin(); it != SectionRegions.end(); ++it) {
             if (Addr >= it->Addr && Addr < (it->Addr + it->Bytes.size())) {
                 uint64_t Next = 0;
-                for (unsigned i = 0; i < FunctionStarts.size(); ++i) {
+                for (unsigned i = 0; i + 1 < FunctionStarts.size(); ++i) {
                     if (FunctionStarts[i] <= Addr && FunctionStarts[i + 1] > Addr) {
                         Next = FunctionStarts[i + 1];
                         break;
                     }
                 }
-                if (Next) {
+                if (Next && Next <= it->Addr + it->Bytes.size()) {
                     ArrayRef<uint8_t> data = it->Bytes.slice(Addr - it->Addr, Next - Addr);
 //                auto Region = std::make_shared<MemoryRegion>(Addr, data);
                     //FIXME: What about releasing??????!!!!!!
@@ -92,6 +92,8 @@ MCObjectDisassembler::getRegionFor(uint64_t Addr) {
 
 MCModule *MCObjectDisassembler::buildEmptyModule() {
   MCModule *Module = new MCModule;
+  if (MOS && MOS->hasCompactOperands())
+    MOS->setOperandModule(Module);
   return Module;
 }
 
@@ -266,6 +268,11 @@ void MCObjectDisassembler::disassembleFunctionAt(
         assert(true);
     }
 
+  // Storage for the instructions decoded ahead, reused for all blocks.
+  const size_t MinBatchSize = 4, MaxBatchSize = 32;
+  MCInst Batch[MaxBatchSize];
+  SmallVector<uint64_t, MaxBatchSize> BatchSizes;
+
   Worklist.insert(BBBeginAddr);
   for (size_t wi = 0; wi < Worklist.size(); ++wi) {
     const uint64_t BeginAddr = Worklist[wi];
@@ -357,17 +364,36 @@ void MCObjectDisassembler::disassembleFunctionAt(
 
       uint64_t InstSize;
 
+      // Decode ahead in batches, never past the end of the block. The block
+      // usually ends at a terminator well before EndAddr though, so start
+      // with a small batch and only grow it as the block goes on.
+      size_t BatchIdx = 0, BatchEnd = 0, NextBatchSize = MinBatchSize;
+
       for (uint64_t Addr = BeginAddr; Addr < EndAddr; Addr += InstSize) {
 
-        MCInst Inst;
-        if (Dis.getInstruction(Inst, InstSize,
-                               Region.Bytes.slice(Addr - Region.Addr), Addr,
-                               nulls(), nulls())) {
+        if (BatchIdx == BatchEnd) {
+          BatchIdx = 0;
+          BatchEnd = Dis.getInstructions(
+              Region.Bytes.slice(Addr - Region.Addr, EndAddr - Addr), Addr,
+              MutableArrayRef<MCInst>(Batch, NextBatchSize), BatchSizes);
+          NextBatchSize = std::min<size_t>(NextBatchSize * 2, MaxBatchSize);
+        }
 
-        } else {
+        MCInst SingleInst;
+        MCInst *InstPtr = &SingleInst;
+        if (BatchIdx != BatchEnd) {
+          InstPtr = &Batch[BatchIdx];
+          InstSize = BatchSizes[BatchIdx++];
+        } else if (!Dis.getInstruction(SingleInst, InstSize,
+                                       Region.Bytes.slice(Addr - Region.Addr),
+                                       Addr, nulls(), nulls())) {
+          // The batch stops at EndAddr, but an instruction may still start
+          // before it and end after it, so only fail if it doesn't decode on
+          // its own either.
           DEBUG(dbgs() << "Failed disassembly at " << utohexstr(Addr) << "!\n");
           break;
         }
+        MCInst &Inst = *InstPtr;
 
         uint64_t BranchTarget;
           bool isTailcall = false;
@@ -555,6 +581,22 @@ llvm::MCObjectDisassembler::AddressSetTy MCObjectDisassembler::findFunctionStart
 //        errs() << utohexstr(f) << "\n";
 //    }
 
+    // Relocatable objects have no LC_FUNCTION_STARTS: use the function
+    // symbols defined in text sections instead.
+    if (Starts.empty() && MachO->getHeader().filetype == MachO::MH_OBJECT) {
+        for (const SymbolRef &Symbol : MachO->symbols()) {
+            if (Symbol.getType() != SymbolRef::ST_Function)
+                continue;
+            ErrorOr<section_iterator> SecOrErr = Symbol.getSection();
+            if (SecOrErr.getError() || *SecOrErr == MachO->section_end() ||
+                !(*SecOrErr)->isText())
+                continue;
+            ErrorOr<uint64_t> AddrOrErr = Symbol.getAddress();
+            if (!AddrOrErr.getError())
+                Starts.push_back(*AddrOrErr);
+        }
+    }
+
     std::sort(Starts.begin(), Starts.end());
 
     return Starts;
@@ -564,15 +606,9 @@ bool MCObjectDisassembler::checkBranch(MCInst &Inst, uint64_t Target) {
     if (!ObjCFile)
         return false;
     std::string FunctionName = ObjCFile->getFunctionName(Target);
-    for (object::section_iterator S_it = Obj.section_begin(); S_it != Obj.section_end(); ++S_it) {
-        StringRef SectionName;
-        if (!S_it->getName(SectionName)) {
-            if (SectionName == "__stubs") {
-                if (S_it->getAddress() <= Target && Target < (S_it->getAddress() + S_it->getSize())) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    const MachOObjectFile &MachO = cast<MachOObjectFile>(Obj);
+    object::section_iterator S_it = MachO.findSection("", "__stubs");
+    if (S_it == MachO.section_end())
+        return false;
+    return S_it->getAddress() <= Target && Target < (S_it->getAddress() + S_it->getSize());
 }
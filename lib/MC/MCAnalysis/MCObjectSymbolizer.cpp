@@ -47,39 +47,36 @@ MCMachObjectSymbolizer::MCMachObjectSymbolizer(
       StubsStart(0), StubsCount(0), StubSize(0), StubsIndSymIndex(0),
       VMAddrSlide(VMAddrSlide) {
 
-  for (const SectionRef &Section : MOOF.sections()) {
-    StringRef Name;
-    Section.getName(Name);
-    if (Name == "__stubs") {
-      SectionRef StubsSec = Section;
-      if (MOOF.is64Bit()) {
-        MachO::section_64 S = MOOF.getSection64(StubsSec.getRawDataRefImpl());
-        StubsIndSymIndex = S.reserved1;
-        StubSize = S.reserved2;
-      } else {
-        MachO::section S = MOOF.getSection(StubsSec.getRawDataRefImpl());
-        StubsIndSymIndex = S.reserved1;
-        StubSize = S.reserved2;
-      }
-      assert(StubSize && "Mach-O stub entry size can't be zero!");
-      StubsStart = StubsSec.getAddress();
-      StubsCount = StubsSec.getSize();
-      StubsCount /= StubSize;
+  section_iterator Stubs = MOOF.findSection("", "__stubs");
+  if (Stubs != MOOF.section_end()) {
+    SectionRef StubsSec = *Stubs;
+    if (MOOF.is64Bit()) {
+      MachO::section_64 S = MOOF.getSection64(StubsSec.getRawDataRefImpl());
+      StubsIndSymIndex = S.reserved1;
+      StubSize = S.reserved2;
+    } else {
+      MachO::section S = MOOF.getSection(StubsSec.getRawDataRefImpl());
+      StubsIndSymIndex = S.reserved1;
+      StubSize = S.reserved2;
     }
+    assert(StubSize && "Mach-O stub entry size can't be zero!");
+    StubsStart = StubsSec.getAddress();
+    StubsCount = StubsSec.getSize();
+    StubsCount /= StubSize;
   }
 
   // Also look for the init/exit func sections.
-  for (const SectionRef &Section : MOOF.sections()) {
-    StringRef Name;
-    Section.getName(Name);
-    // FIXME: We should use the S_ section type instead of the name.
-    if (Name == "__mod_init_func") {
-      DEBUG(dbgs() << "Found __mod_init_func section!\n");
-      Section.getContents(ModInitContents);
-    } else if (Name == "__mod_exit_func") {
-      DEBUG(dbgs() << "Found __mod_exit_func section!\n");
-      Section.getContents(ModExitContents);
-    }
+  ArrayRef<SectionRef> ModInit =
+      MOOF.sectionsOfType(MachO::S_MOD_INIT_FUNC_POINTERS);
+  if (!ModInit.empty()) {
+    DEBUG(dbgs() << "Found __mod_init_func section!\n");
+    ModInit.front().getContents(ModInitContents);
+  }
+  ArrayRef<SectionRef> ModExit =
+      MOOF.sectionsOfType(MachO::S_MOD_TERM_FUNC_POINTERS);
+  if (!ModExit.empty()) {
+    DEBUG(dbgs() << "Found __mod_exit_func section!\n");
+    ModExit.front().getContents(ModExitContents);
   }
 }
 
@@ -214,7 +211,8 @@ MCObjectSymbolizer::MCObjectSymbolizer(
     MCContext &Ctx, std::unique_ptr<MCRelocationInfo> RelInfo,
     const ObjectFile &Obj)
     : MCSymbolizer(Ctx, std::move(RelInfo)), Obj(Obj),
-      SymbolSizes(computeSymbolSizes(Obj)) {
+      SymbolSizes(computeSymbolSizes(Obj)), CompactOperands(false),
+      OperandModule(nullptr) {
   buildSectionList();
 }
 
@@ -245,10 +243,19 @@ bool MCObjectSymbolizer::
 tryAddingSymbolicOperand(MCInst &MI, raw_ostream &cStream,
                          int64_t Value, uint64_t Address, bool IsBranch,
                          uint64_t Offset, uint64_t InstSize) {
+  // In compact mode, record the operand and leave it as an immediate.
+  MCModule *Module = CompactOperands ? OperandModule : nullptr;
+  const uint32_t OpIdx = MI.getNumOperands();
+
   if (IsBranch) {
     StringRef ExtFnName = findExternalFunctionAt((uint64_t)Value);
     if (!ExtFnName.empty()) {
       MCSymbol *Sym = Ctx.getOrCreateSymbol(ExtFnName);
+      if (Module) {
+        Module->addSymbolicOperand(Address, Value,
+                                   getOperandSymbolIdx(Sym, Value), OpIdx);
+        return false;
+      }
       const MCExpr *Expr = MCSymbolRefExpr::create(Sym, Ctx);
       MI.addOperand(MCOperand::createExpr(Expr));
       return true;
@@ -256,6 +263,11 @@ tryAddingSymbolicOperand(MCInst &MI, raw_ostream &cStream,
   }
 
   if (const RelocationRef *R = findRelocationAt(Address + Offset)) {
+    if (Module) {
+      Module->addSymbolicOperand(Address, Address + Offset,
+                                 RelocationSymbolIdx, OpIdx);
+      return false;
+    }
     if (const MCExpr *RelExpr = RelInfo->createExprForRelocation(*R)) {
       MI.addOperand(MCOperand::createExpr(RelExpr));
       return true;
@@ -273,6 +285,11 @@ tryAddingSymbolicOperand(MCInst &MI, raw_ostream &cStream,
 
   if (!Sym)
     return false;
+  if (Module) {
+    Module->addSymbolicOperand(
+        Address, Value, getOperandSymbolIdx(Sym, Value - SymbolOffset), OpIdx);
+    return false;
+  }
   const MCExpr *Expr = MCSymbolRefExpr::create(Sym, Ctx);
   if (SymbolOffset) {
     const MCExpr *Off = MCConstantExpr::create(SymbolOffset, Ctx);
@@ -282,6 +299,44 @@ tryAddingSymbolicOperand(MCInst &MI, raw_ostream &cStream,
   return true;
 }
 
+uint32_t MCObjectSymbolizer::getOperandSymbolIdx(MCSymbol *Sym,
+                                                 uint64_t Addr) {
+  auto InsertResult = OperandSymbolIndices.insert(
+      std::make_pair(std::make_pair(Sym, Addr), OperandSymbols.size()));
+  if (InsertResult.second) {
+    OperandSymbol OS = {Sym, Addr};
+    OperandSymbols.push_back(OS);
+  }
+  return InsertResult.first->second;
+}
+
+const MCExpr *MCObjectSymbolizer::createSymbolicOperandExpr(
+    const MCModule::SymbolicOperand &SO) {
+  if (SO.SymbolIdx == RelocationSymbolIdx) {
+    if (const RelocationRef *R = findRelocationAt(SO.TargetAddr))
+      return RelInfo->createExprForRelocation(*R);
+    return nullptr;
+  }
+  assert(SO.SymbolIdx < OperandSymbols.size() && "Invalid symbol index!");
+  const OperandSymbol &OS = OperandSymbols[SO.SymbolIdx];
+  const MCExpr *Expr = MCSymbolRefExpr::create(OS.Sym, Ctx);
+  if (uint64_t SymbolOffset = SO.TargetAddr - OS.Addr) {
+    const MCExpr *Off = MCConstantExpr::create(SymbolOffset, Ctx);
+    Expr = MCBinaryExpr::createAdd(Expr, Off, Ctx);
+  }
+  return Expr;
+}
+
+void MCObjectSymbolizer::materializeSymbolicOperands(MCInst &MI, uint64_t Addr,
+                                                     const MCModule &Module) {
+  for (const MCModule::SymbolicOperand &SO : Module.getSymbolicOperands(Addr)) {
+    if (SO.OpIdx >= MI.getNumOperands())
+      continue;
+    if (const MCExpr *Expr = createSymbolicOperandExpr(SO))
+      MI.getOperand(SO.OpIdx) = MCOperand::createExpr(Expr);
+  }
+}
+
 MCSymbol *MCObjectSymbolizer::
 findContainingFunction(uint64_t Addr, uint64_t &Offset)
 {
@@ -365,13 +420,15 @@ MCObjectSymbolizer::findSectionInfoContaining(uint64_t Addr) const {
 
 MCObjectSymbolizer::SectionInfo *
 MCObjectSymbolizer::findSectionInfoContaining(uint64_t Addr) {
-  auto EndIt = SortedSections.end(),
-       It = std::lower_bound(SortedSections.begin(), EndIt, Addr);
-  if (It == EndIt)
+  // Find the last section that starts at or before Addr; sections don't
+  // overlap, so it's the only one that can contain it.
+  auto It = std::upper_bound(
+      SortedSections.begin(), SortedSections.end(), Addr,
+      [](uint64_t A, const SectionInfo &SI) { return A < SI.Addr; });
+  if (It == SortedSections.begin())
     return nullptr;
-  uint64_t SAddr = It->Section.getAddress();
-  uint64_t SSize = It->Section.getSize();
-  if (Addr >= SAddr + SSize || Addr < SAddr)
+  --It;
+  if (Addr - It->Addr >= It->Size)
     return nullptr;
   return &*It;
 }
@@ -389,9 +446,12 @@ const RelocationRef *MCObjectSymbolizer::findRelocationAt(uint64_t Addr) const {
 }
 
 void MCObjectSymbolizer::buildSectionList() {
+  // Empty sections can't contain anything, and would make the lookup
+  // ambiguous when they share their address with another section.
   for (const SectionRef &Section : Obj.sections())
-    SortedSections.push_back(Section);
-  std::sort(SortedSections.begin(), SortedSections.end());
+    if (Section.getSize())
+      SortedSections.push_back(Section);
+  std::stable_sort(SortedSections.begin(), SortedSections.end());
 
   uint64_t PrevSecEnd = 0;
   for (auto &SecInfo : SortedSections) {
@@ -399,8 +459,8 @@ void MCObjectSymbolizer::buildSectionList() {
     buildRelocationByAddrMap(SecInfo);
 
     // Also, sanity check that we don't have overlapping sections.
-    uint64_t SAddr = SecInfo.Section.getAddress();
-    uint64_t SSize = SecInfo.Section.getSize();
+    uint64_t SAddr = SecInfo.Addr;
+    uint64_t SSize = SecInfo.Size;
     if (PrevSecEnd > SAddr)
       llvm_unreachable("Inserting overlapping sections");
     PrevSecEnd = std::max(PrevSecEnd, SAddr + SSize);
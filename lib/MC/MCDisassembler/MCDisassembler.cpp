@@ -9,6 +9,7 @@
 
 #include "llvm/MC/MCDisassembler.h"
 #include "llvm/MC/MCExternalSymbolizer.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -16,6 +17,37 @@ using namespace llvm;
 MCDisassembler::~MCDisassembler() {
 }
 
+size_t MCDisassembler::getInstructions(
+    ArrayRef<uint8_t> Bytes, uint64_t Address, MutableArrayRef<MCInst> Insts,
+    SmallVectorImpl<uint64_t> &Sizes, raw_ostream &VStream,
+    raw_ostream &CStream, SmallVectorImpl<uint64_t> *CommentEnds) const {
+  Sizes.clear();
+  if (CommentEnds)
+    CommentEnds->clear();
+  uint64_t Offset = 0;
+  for (size_t i = 0, e = Insts.size(); i != e && Offset < Bytes.size(); ++i) {
+    MCInst &Inst = Insts[i];
+    uint64_t Size;
+    Inst.clear();
+    if (getInstruction(Inst, Size, Bytes.slice(Offset), Address + Offset,
+                       VStream, CStream) == Fail)
+      break;
+    Sizes.push_back(Size);
+    if (CommentEnds)
+      CommentEnds->push_back(CStream.tell());
+    Offset += Size;
+  }
+  return Sizes.size();
+}
+
+size_t MCDisassembler::getInstructions(ArrayRef<uint8_t> Bytes,
+                                       uint64_t Address,
+                                       MutableArrayRef<MCInst> Insts,
+                                       SmallVectorImpl<uint64_t> &Sizes) const {
+  return getInstructions(Bytes, Address, Insts, Sizes, nulls(), nulls(),
+                         nullptr);
+}
+
 bool MCDisassembler::tryAddingSymbolicOperand(MCInst &Inst, int64_t Value,
                                               uint64_t Address, bool IsBranch,
                                               uint64_t Offset,
@@ -25,8 +25,10 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
+#include <cstddef>
 #include <cstring>
 #include <limits>
+#include <tuple>
 
 using namespace llvm;
 using namespace object;
@@ -2291,6 +2293,176 @@ bool MachOObjectFile::isRelocatableObject() const {
   return getHeader().filetype == MachO::MH_OBJECT;
 }
 
+MachOObjectFile::~MachOObjectFile() {}
+
+// The section and segment lookup index.
+struct MachOObjectFile::LookupIndex {
+  struct NamedSection {
+    StringRef SectName;
+    StringRef SegName;
+    unsigned SectIdx;
+    bool operator<(const NamedSection &RHS) const {
+      return std::tie(SectName, SegName, SectIdx) <
+             std::tie(RHS.SectName, RHS.SegName, RHS.SectIdx);
+    }
+  };
+  // Sorted by section name, then segment name, then section index.
+  std::vector<NamedSection> SectionsByName;
+  // Sorted by type, then section index; SectionTypes is parallel to it.
+  std::vector<SectionRef> SectionsByType;
+  std::vector<unsigned> SectionTypes;
+  // In load command order.
+  std::vector<SegmentInfo> Segments;
+  // Indices of the non-empty segments, sorted by VMAddr and FileOff.
+  std::vector<unsigned> SegmentsByAddr;
+  std::vector<unsigned> SegmentsByOffset;
+};
+
+template <typename SegmentCmd>
+static MachOObjectFile::SegmentInfo
+getSegmentInfo(const SegmentCmd &S, const char *LoadPtr, unsigned Index) {
+  MachOObjectFile::SegmentInfo Seg;
+  // S is a copy: point the name at the load command itself.
+  const char *SegName = LoadPtr + offsetof(SegmentCmd, segname);
+  Seg.Name = StringRef(SegName, strnlen(S.segname, sizeof(S.segname)));
+  Seg.VMAddr = S.vmaddr;
+  Seg.VMSize = S.vmsize;
+  Seg.FileOff = S.fileoff;
+  Seg.FileSize = S.filesize;
+  Seg.MaxProt = S.maxprot;
+  Seg.InitProt = S.initprot;
+  Seg.Index = Index;
+  return Seg;
+}
+
+const MachOObjectFile::LookupIndex &MachOObjectFile::getLookupIndex() const {
+  if (Index)
+    return *Index;
+  std::unique_ptr<LookupIndex> LI(new LookupIndex);
+
+  std::vector<std::pair<unsigned, unsigned>> TypeAndIdx;
+  for (unsigned i = 0, e = Sections.size(); i != e; ++i) {
+    DataRefImpl DRI;
+    DRI.d.a = i;
+    LookupIndex::NamedSection NS;
+    getSectionName(DRI, NS.SectName);
+    NS.SegName = getSectionFinalSegmentName(DRI);
+    NS.SectIdx = i;
+    LI->SectionsByName.push_back(NS);
+    TypeAndIdx.push_back(
+        std::make_pair(getSectionFlags(this, DRI) & MachO::SECTION_TYPE, i));
+  }
+  std::sort(LI->SectionsByName.begin(), LI->SectionsByName.end());
+  std::sort(TypeAndIdx.begin(), TypeAndIdx.end());
+  for (const auto &TI : TypeAndIdx) {
+    DataRefImpl DRI;
+    DRI.d.a = TI.second;
+    LI->SectionTypes.push_back(TI.first);
+    LI->SectionsByType.push_back(SectionRef(DRI, this));
+  }
+
+  for (const LoadCommandInfo &Load : LoadCommands) {
+    unsigned SegIdx = LI->Segments.size();
+    if (Load.C.cmd == MachO::LC_SEGMENT_64)
+      LI->Segments.push_back(
+          getSegmentInfo(getSegment64LoadCommand(Load), Load.Ptr, SegIdx));
+    else if (Load.C.cmd == MachO::LC_SEGMENT)
+      LI->Segments.push_back(
+          getSegmentInfo(getSegmentLoadCommand(Load), Load.Ptr, SegIdx));
+  }
+  const std::vector<SegmentInfo> &Segs = LI->Segments;
+  for (unsigned i = 0, e = Segs.size(); i != e; ++i) {
+    if (Segs[i].VMSize)
+      LI->SegmentsByAddr.push_back(i);
+    if (Segs[i].FileSize)
+      LI->SegmentsByOffset.push_back(i);
+  }
+  std::stable_sort(LI->SegmentsByAddr.begin(), LI->SegmentsByAddr.end(),
+                   [&](unsigned LHS, unsigned RHS) {
+                     return Segs[LHS].VMAddr < Segs[RHS].VMAddr;
+                   });
+  std::stable_sort(LI->SegmentsByOffset.begin(), LI->SegmentsByOffset.end(),
+                   [&](unsigned LHS, unsigned RHS) {
+                     return Segs[LHS].FileOff < Segs[RHS].FileOff;
+                   });
+
+  Index = std::move(LI);
+  return *Index;
+}
+
+section_iterator MachOObjectFile::findSection(StringRef SegName,
+                                              StringRef SectName) const {
+  const LookupIndex &LI = getLookupIndex();
+  auto I = std::lower_bound(
+      LI.SectionsByName.begin(), LI.SectionsByName.end(), SectName,
+      [](const LookupIndex::NamedSection &NS, StringRef Name) {
+        return NS.SectName < Name;
+      });
+  const LookupIndex::NamedSection *Found = nullptr;
+  for (auto E = LI.SectionsByName.end(); I != E && I->SectName == SectName;
+       ++I) {
+    if (!SegName.empty()) {
+      // Entries with the same section name are sorted by segment name.
+      if (I->SegName < SegName)
+        continue;
+      if (I->SegName == SegName)
+        Found = &*I;
+      break;
+    }
+    if (!Found || I->SectIdx < Found->SectIdx)
+      Found = &*I;
+  }
+  if (!Found)
+    return section_end();
+  DataRefImpl DRI;
+  DRI.d.a = Found->SectIdx;
+  return section_iterator(SectionRef(DRI, this));
+}
+
+ArrayRef<SectionRef> MachOObjectFile::sectionsOfType(unsigned Type) const {
+  const LookupIndex &LI = getLookupIndex();
+  auto Range =
+      std::equal_range(LI.SectionTypes.begin(), LI.SectionTypes.end(), Type);
+  return makeArrayRef(LI.SectionsByType)
+      .slice(Range.first - LI.SectionTypes.begin(),
+             Range.second - Range.first);
+}
+
+ArrayRef<MachOObjectFile::SegmentInfo> MachOObjectFile::segments() const {
+  return getLookupIndex().Segments;
+}
+
+const MachOObjectFile::SegmentInfo *
+MachOObjectFile::findSegmentContaining(uint64_t VMAddr) const {
+  const LookupIndex &LI = getLookupIndex();
+  auto I = std::upper_bound(LI.SegmentsByAddr.begin(), LI.SegmentsByAddr.end(),
+                            VMAddr, [&](uint64_t Addr, unsigned SegIdx) {
+                              return Addr < LI.Segments[SegIdx].VMAddr;
+                            });
+  if (I == LI.SegmentsByAddr.begin())
+    return nullptr;
+  const SegmentInfo &Seg = LI.Segments[*--I];
+  if (VMAddr - Seg.VMAddr >= Seg.VMSize)
+    return nullptr;
+  return &Seg;
+}
+
+const MachOObjectFile::SegmentInfo *
+MachOObjectFile::findSegmentForFileOffset(uint64_t FileOffset) const {
+  const LookupIndex &LI = getLookupIndex();
+  auto I = std::upper_bound(LI.SegmentsByOffset.begin(),
+                            LI.SegmentsByOffset.end(), FileOffset,
+                            [&](uint64_t Off, unsigned SegIdx) {
+                              return Off < LI.Segments[SegIdx].FileOff;
+                            });
+  if (I == LI.SegmentsByOffset.begin())
+    return nullptr;
+  const SegmentInfo &Seg = LI.Segments[*--I];
+  if (FileOffset - Seg.FileOff >= Seg.FileSize)
+    return nullptr;
+  return &Seg;
+}
+
 ErrorOr<std::unique_ptr<MachOObjectFile>>
 ObjectFile::createMachOObjectFile(MemoryBufferRef Buffer) {
   StringRef Magic = Buffer.getBuffer().slice(0, 4);
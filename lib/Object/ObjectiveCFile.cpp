@@ -10,41 +10,21 @@ using namespace object;
 
 
 void ObjectiveCFile::resolveMethods() {
-    for(section_iterator S_it = MachO->section_begin(); S_it != MachO->section_end(); ++S_it){
-        StringRef SectionName;
-        S_it->getName(SectionName);
-        if (SectionName == "__objc_classlist") {
-            ObjcClasslistAddress = S_it->getAddress();
-            StringRef ObjcClasslistContent;
-            S_it->getContents(ObjcClasslistContent);
-            ObjcClasslistData = ArrayRef<uint8_t>((uint8_t*)ObjcClasslistContent.data(), ObjcClasslistContent.size());
-        } else if (SectionName == "__objc_data") {
-            ObjcDataAddress = S_it->getAddress();
-            StringRef ObjcDataContent;
-            S_it->getContents(ObjcDataContent);
-            ObjcDataData = ArrayRef<uint8_t>((uint8_t*)ObjcDataContent.data(), ObjcDataContent.size());
-        } else if (SectionName == "__objc_const") {
-            ObjcConstAddress = S_it->getAddress();
-            StringRef ObjcConstContent;
-            S_it->getContents(ObjcConstContent);
-            ObjcConstData = ArrayRef<uint8_t>((uint8_t*)ObjcConstContent.data(), ObjcConstContent.size());
-        } else if (SectionName == "__objc_classname") {
-            ObjcClassnamesAddress = S_it->getAddress();
-            StringRef ObjcClassnamesContent;
-            S_it->getContents(ObjcClassnamesContent);
-            ObjcClassnamesData = ArrayRef<uint8_t>((uint8_t*)ObjcClassnamesContent.data(), ObjcClassnamesContent.size());
-        } else if (SectionName == "__objc_methname") {
-            ObjcMethodnamesAddress = S_it->getAddress();
-            StringRef ObjcMethodnamesContent;
-            S_it->getContents(ObjcMethodnamesContent);
-            ObjcMethodnamesData = ArrayRef<uint8_t>((uint8_t*)ObjcMethodnamesContent.data(), ObjcMethodnamesContent.size());
-        } else if (SectionName == "__objc_catlist") {
-            ObjcCatlistAddress = S_it->getAddress();
-            StringRef ObjcCatlistContent;
-            S_it->getContents(ObjcCatlistContent);
-            ObjcCatlistData = ArrayRef<uint8_t>((uint8_t*)ObjcCatlistContent.data(), ObjcCatlistContent.size());
-        }
-    }
+    auto GetSection = [&](StringRef SectionName, uint64_t &Address, ArrayRef<uint8_t> &Data) {
+        section_iterator S_it = MachO->findSection("", SectionName);
+        if (S_it == MachO->section_end())
+            return;
+        Address = S_it->getAddress();
+        StringRef Content;
+        S_it->getContents(Content);
+        Data = ArrayRef<uint8_t>((uint8_t*)Content.data(), Content.size());
+    };
+    GetSection("__objc_classlist", ObjcClasslistAddress, ObjcClasslistData);
+    GetSection("__objc_data", ObjcDataAddress, ObjcDataData);
+    GetSection("__objc_const", ObjcConstAddress, ObjcConstData);
+    GetSection("__objc_classname", ObjcClassnamesAddress, ObjcClassnamesData);
+    GetSection("__objc_methname", ObjcMethodnamesAddress, ObjcMethodnamesData);
+    GetSection("__objc_catlist", ObjcCatlistAddress, ObjcCatlistData);
 
     if (!(ObjcClasslistAddress && ObjcClasslistData.size())) {
         return;
@@ -214,8 +194,7 @@ StringRef ObjectiveCFile::getClassName(uint64_t Pointer) {
             Offset = decodeULEB128(BindOpcodes.slice(Idx).data(), &n);
             Idx += n;
         } else if (Opcode == MachO::BIND_OPCODE_DO_BIND) {
-            MachO::segment_command_64 Segment = getSegment(SegmentNo);
-            if (Segment.vmaddr + Offset == Pointer) {
+            if (getSegment(SegmentNo).VMAddr + Offset == Pointer) {
                 return SymbolName;
             }
             //FIXME: is this add correct???
@@ -228,10 +207,10 @@ StringRef ObjectiveCFile::getClassName(uint64_t Pointer) {
             Idx += n;
         } else if ((Opcode & ~0xF) == MachO::BIND_OPCODE_DO_BIND_ADD_ADDR_IMM_SCALED) {
             unsigned Scaled = (Opcode & 0xF) * 8;
-            if (getSegment(SegmentNo).vmaddr + Offset == Pointer) {
+            if (getSegment(SegmentNo).VMAddr + Offset == Pointer) {
                 return SymbolName;
             }
-//            addClass(SymbolName, getSegment(SegmentNo).vmaddr + Offset);
+//            addClass(SymbolName, getSegment(SegmentNo).VMAddr + Offset);
             //FIXME: again the add of 8
             Offset += Scaled + 8;
             Idx++;
@@ -244,16 +223,16 @@ StringRef ObjectiveCFile::getClassName(uint64_t Pointer) {
             n = 0;
             uint64_t Skip = decodeULEB128(BindOpcodes.slice(Idx).data(), &n);
             for (unsigned i = 0; i < Count; ++i) {
-//                addClass(SymbolName, getSegment(SegmentNo).vmaddr + Offset);
-                if (getSegment(SegmentNo).vmaddr + Offset == Pointer) {
+//                addClass(SymbolName, getSegment(SegmentNo).VMAddr + Offset);
+                if (getSegment(SegmentNo).VMAddr + Offset == Pointer) {
                     return SymbolName;
                 }
                 Offset += 8 + Skip;
             }
             Idx += n;
         } else if (Opcode == MachO::BIND_OPCODE_DO_BIND_ADD_ADDR_ULEB) {
-//            addClass(SymbolName, getSegment(SegmentNo).vmaddr + Offset);
-            if (getSegment(SegmentNo).vmaddr + Offset == Pointer) {
+//            addClass(SymbolName, getSegment(SegmentNo).VMAddr + Offset);
+            if (getSegment(SegmentNo).VMAddr + Offset == Pointer) {
                 return SymbolName;
             }
             Idx++;
@@ -281,17 +260,9 @@ StringRef ObjectiveCFile::getClassName(uint64_t Pointer) {
     llvm_unreachable("");
 }
 
-MachO::segment_command_64 ObjectiveCFile::getSegment(uint64_t SegmentNo) {
-    uint64_t Idx = 0;
-    for(object::MachOObjectFile::load_command_iterator L_it = MachO->begin_load_commands();
-        L_it != MachO->end_load_commands(); ++L_it) {
-        if (L_it->C.cmd == MachO::LC_SEGMENT_64) {
-            if (Idx == SegmentNo) {
-                return MachO->getSegment64LoadCommand(*L_it);
-            } else {
-                Idx++;
-            }
-        }
-    }
+const object::MachOObjectFile::SegmentInfo &ObjectiveCFile::getSegment(uint64_t SegmentNo) {
+    ArrayRef<object::MachOObjectFile::SegmentInfo> Segments = MachO->segments();
+    if (SegmentNo < Segments.size())
+        return Segments[SegmentNo];
     llvm_unreachable("Cant find segment");
 };
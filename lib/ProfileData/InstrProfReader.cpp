@@ -21,11 +21,23 @@ using namespace llvm;
 
 static ErrorOr<std::unique_ptr<MemoryBuffer>>
 setupMemoryBuffer(std::string Path) {
+  // The binary formats don't need a null terminator, which lets large
+  // inputs always be mapped rather than copied.
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFileOrSTDIN(Path);
+      Path == "-" ? MemoryBuffer::getSTDIN()
+                  : MemoryBuffer::getFile(Path, -1,
+                                          /*RequiresNullTerminator=*/false);
   if (std::error_code EC = BufferOrErr.getError())
     return EC;
-  return std::move(BufferOrErr.get());
+  std::unique_ptr<MemoryBuffer> Buffer = std::move(BufferOrErr.get());
+
+  // The text reader does rely on it, though.
+  if (!IndexedInstrProfReader::hasFormat(*Buffer) &&
+      !RawInstrProfReader64::hasFormat(*Buffer) &&
+      !RawInstrProfReader32::hasFormat(*Buffer))
+    Buffer = MemoryBuffer::getMemBufferCopy(Buffer->getBuffer(),
+                                            Buffer->getBufferIdentifier());
+  return std::move(Buffer);
 }
 
 static std::error_code initializeReader(InstrProfReader &Reader) {
@@ -420,7 +432,6 @@ IndexedInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   if ((*RecordIterator).empty())
     return error(instrprof_error::malformed);
 
-  static unsigned RecordIndex = 0;
   ArrayRef<InstrProfRecord> Data = (*RecordIterator);
   Record = Data[RecordIndex++];
   if (RecordIndex >= Data.size()) {
@@ -17,6 +17,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/OnDiskHashTable.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -61,10 +62,17 @@ public:
     using namespace llvm::support;
     endian::Writer<little> LE(Out);
 
-    for (const auto &Counts : *V) {
-      LE.write<uint64_t>(Counts.first);
-      LE.write<uint64_t>(Counts.second.size());
-      for (uint64_t I : Counts.second)
+    // Emit the hashes in order, so that the output doesn't depend on the
+    // order the counts were added in.
+    SmallVector<uint64_t, 1> Hashes;
+    for (const auto &Counts : *V)
+      Hashes.push_back(Counts.first);
+    std::sort(Hashes.begin(), Hashes.end());
+    for (uint64_t Hash : Hashes) {
+      const auto &Counts = V->find(Hash)->second;
+      LE.write<uint64_t>(Hash);
+      LE.write<uint64_t>(Counts.size());
+      for (uint64_t I : Counts)
         LE.write<uint64_t>(I);
     }
   }
@@ -91,8 +99,16 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   auto &FoundCounters = Where->second;
   // If the number of counters doesn't match we either have bad data or a hash
   // collision.
-  if (FoundCounters.size() != Counters.size())
+  if (FoundCounters.size() != Counters.size()) {
+    auto &Mismatched = MismatchedData[FunctionName][std::make_pair(
+        FunctionHash, Counters.size())];
+    if (Mismatched.empty())
+      Mismatched = Counters;
+    else
+      for (size_t I = 0, E = Counters.size(); I < E; ++I)
+        Mismatched[I] += Counters[I];
     return instrprof_error::count_mismatch;
+  }
 
   for (size_t I = 0, E = Counters.size(); I < E; ++I) {
     if (FoundCounters[I] + Counters[I] < FoundCounters[I])
@@ -106,12 +122,47 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   return instrprof_error::success;
 }
 
+void InstrProfWriter::mergeRecordsFromWriter(
+    InstrProfWriter &&IPW,
+    function_ref<void(StringRef, std::error_code)> Warn) {
+  for (auto &I : IPW.FunctionData) {
+    auto Where = FunctionData.find(I.getKey());
+    if (Where == FunctionData.end()) {
+      // Nothing to sum: take the counts over.
+      for (const auto &Counts : I.getValue())
+        if (Counts.second[0] > MaxFunctionCount)
+          MaxFunctionCount = Counts.second[0];
+      FunctionData[I.getKey()] = std::move(I.getValue());
+      continue;
+    }
+    for (const auto &Counts : I.getValue())
+      if (std::error_code EC =
+              addFunctionCounts(I.getKey(), Counts.first, Counts.second))
+        Warn(I.getKey(), EC);
+  }
+
+  // The counts IPW rejected were added after the ones it kept. They were
+  // already diagnosed, but may match the counts this writer added first.
+  for (const auto &I : IPW.MismatchedData)
+    for (const auto &Counts : I.getValue())
+      addFunctionCounts(I.getKey(), Counts.first.first, Counts.second);
+}
+
 std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
   OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
 
-  // Populate the hash table generator.
+  // Populate the hash table generator, in name order so that the output
+  // doesn't depend on the order the functions were added in.
+  std::vector<const StringMapEntry<CounterData> *> Functions;
   for (const auto &I : FunctionData)
-    Generator.insert(I.getKey(), &I.getValue());
+    Functions.push_back(&I);
+  std::sort(Functions.begin(), Functions.end(),
+            [](const StringMapEntry<CounterData> *LHS,
+               const StringMapEntry<CounterData> *RHS) {
+    return LHS->getKey() < RHS->getKey();
+  });
+  for (const auto *I : Functions)
+    Generator.insert(I->getKey(), &I->getValue());
 
   using namespace llvm::support;
   endian::Writer<little> LE(OS);
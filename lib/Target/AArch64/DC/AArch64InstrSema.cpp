@@ -543,7 +543,7 @@ void AArch64InstrSema::translateCustomOperand(unsigned OperandType, unsigned MIO
                     break;
             }
             Value *OpReg = getReg(getRegOp(MIOperandNo));
-            OpReg = Builder->CreateShl(OpReg, getImmOp(MIOperandNo + 1));
+            OpReg = ShiftReg(OpReg, getImmOp(MIOperandNo + 1));
             registerResult(OpReg);
             break;
         }
@@ -917,22 +917,7 @@ void AArch64InstrSema::translateCustomOperand(unsigned OperandType, unsigned MIO
             }
 
             Value *Reg = getReg(getRegOp(MIOperandNo));
-            uint64_t Shift = getImmOp(MIOperandNo + 1);
-
-            if (Shift > Reg->getType()->getIntegerBitWidth() * 3) {
-                Shift = Shift % Reg->getType()->getIntegerBitWidth();
-                Value *LSBits = Builder->getInt(APInt(Reg->getType()->getIntegerBitWidth(), getOnes(Shift)));
-                LSBits = Builder->CreateAnd(Reg, LSBits);
-                LSBits = Builder->CreateShl(LSBits, Reg->getType()->getIntegerBitWidth() - Shift);
-                Reg = Builder->CreateLShr(Reg, Shift);
-                Reg = Builder->CreateOr(Reg, LSBits);
-            } else if (Shift > Reg->getType()->getIntegerBitWidth() * 2) {
-                Reg = Builder->CreateAShr(Reg, Shift % Reg->getType()->getIntegerBitWidth());
-            } else if (Shift > Reg->getType()->getIntegerBitWidth()) {
-                Reg = Builder->CreateLShr(Reg, Shift % Reg->getType()->getIntegerBitWidth());
-            } else {
-                Reg = Builder->CreateShl(Reg, Shift);
-            }
+            Reg = ShiftReg(Reg, getImmOp(MIOperandNo + 1));
             registerResult(Reg);
             break;
         }
@@ -1405,6 +1390,29 @@ Value *AArch64InstrSema::ArithExtend(Value *Value, Type *ExtType, uint64_t Ext)
     return Value;
 }
 
+// The shifter operand encodes both the shift type and amount, see
+// AArch64_AM::getShifterImm.
+Value *AArch64InstrSema::ShiftReg(Value *Reg, uint64_t ShifterImm) {
+    unsigned Amount = AArch64_AM::getShiftValue(ShifterImm);
+    switch (AArch64_AM::getShiftType(ShifterImm)) {
+        default:
+            llvm_unreachable("Unhandled register shift type");
+        case AArch64_AM::LSL:
+            return Builder->CreateShl(Reg, Amount);
+        case AArch64_AM::LSR:
+            return Builder->CreateLShr(Reg, Amount);
+        case AArch64_AM::ASR:
+            return Builder->CreateAShr(Reg, Amount);
+        case AArch64_AM::ROR: {
+            if (!Amount)
+                return Reg;
+            unsigned Width = Reg->getType()->getIntegerBitWidth();
+            return Builder->CreateOr(Builder->CreateLShr(Reg, Amount),
+                                     Builder->CreateShl(Reg, Width - Amount));
+        }
+    }
+}
+
 Value *AArch64InstrSema::FPCompare(Value * LHS, Value * RHS) {
     Value *Sub = Builder->CreateFSub(LHS, RHS);
 
@@ -26,6 +26,7 @@ private:
     Value *getNZCVFlag(Value *N, Value *Z, Value *C = NULL, Value *V = NULL);
 
     Value *ArithExtend(Value *Value, Type *ExtType, uint64_t Ext);
+    Value *ShiftReg(Value *Reg, uint64_t ShifterImm);
     Value *FPCompare(Value *LHS, Value *RHS);
 };
 }
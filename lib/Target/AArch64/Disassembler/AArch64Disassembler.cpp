@@ -194,6 +194,7 @@ static bool Check(DecodeStatus &Out, DecodeStatus In) {
 }
 
 #include "AArch64GenDisassemblerTables.inc"
+#include "AArch64GenDisassemblerDirect.inc"
 #include "AArch64GenInstrInfo.inc"
 
 #define Success llvm::MCDisassembler::Success
@@ -223,7 +224,52 @@ DecodeStatus AArch64Disassembler::getInstruction(MCInst &MI, uint64_t &Size,
   uint32_t Insn =
       (Bytes[3] << 24) | (Bytes[2] << 16) | (Bytes[1] << 8) | (Bytes[0] << 0);
 
-  // Calling the auto-generated decoder function.
+  // Calling the auto-generated direct-dispatch decoder function.
+  return decodeInstructionDirect32(MI, Insn, Address, this, STI);
+}
+
+size_t AArch64Disassembler::getInstructions(
+    ArrayRef<uint8_t> Bytes, uint64_t Address, MutableArrayRef<MCInst> Insts,
+    SmallVectorImpl<uint64_t> &Sizes, raw_ostream &VStream,
+    raw_ostream &CStream, SmallVectorImpl<uint64_t> *CommentEnds) const {
+  CommentStream = &CStream;
+
+  const size_t NumInsts = std::min<size_t>(Insts.size(), Bytes.size() / 4);
+  Sizes.assign(NumInsts, 4);
+  if (CommentEnds)
+    CommentEnds->clear();
+
+  // The feature bits don't change from one instruction to the next, so only
+  // look them up once for the whole batch.
+  const FeatureBitset &Bits = STI.getFeatureBits();
+  const uint8_t *Ptr = Bytes.data();
+  for (size_t i = 0; i != NumInsts; ++i, Ptr += 4) {
+    uint32_t Insn = (Ptr[3] << 24) | (Ptr[2] << 16) | (Ptr[1] << 8) | Ptr[0];
+    if (decodeInstructionDirect32(Insts[i], Insn, Address + 4 * i, this,
+                                  Bits) == Fail) {
+      Sizes.resize(i);
+      return i;
+    }
+    if (CommentEnds)
+      CommentEnds->push_back(CStream.tell());
+  }
+  return NumInsts;
+}
+
+DecodeStatus AArch64Disassembler::getInstructionFromTable(
+    MCInst &MI, uint64_t &Size, ArrayRef<uint8_t> Bytes, uint64_t Address,
+    raw_ostream &OS, raw_ostream &CS) const {
+  CommentStream = &CS;
+
+  Size = 0;
+  if (Bytes.size() < 4)
+    return Fail;
+  Size = 4;
+
+  uint32_t Insn =
+      (Bytes[3] << 24) | (Bytes[2] << 16) | (Bytes[1] << 8) | (Bytes[0] << 0);
+
+  // Calling the auto-generated decoder table interpreter.
   return decodeInstruction(DecoderTable32, MI, Insn, Address, this, STI);
 }
 
@@ -32,6 +32,25 @@ public:
   getInstruction(MCInst &Instr, uint64_t &Size, ArrayRef<uint8_t> Bytes,
                  uint64_t Address, raw_ostream &VStream,
                  raw_ostream &CStream) const override;
+
+  /// AArch64 instructions are all 4 bytes wide, so the instruction boundaries
+  /// are known upfront: decode the words directly, without going through
+  /// getInstruction for each of them.
+  size_t getInstructions(ArrayRef<uint8_t> Bytes, uint64_t Address,
+                         MutableArrayRef<MCInst> Insts,
+                         SmallVectorImpl<uint64_t> &Sizes,
+                         raw_ostream &VStream, raw_ostream &CStream,
+                         SmallVectorImpl<uint64_t> *CommentEnds) const override;
+  using MCDisassembler::getInstructions;
+
+  /// Decode an instruction by interpreting the decoder tables rather than
+  /// using the generated direct-dispatch decoder that getInstruction uses.
+  /// Both are generated from the same decoding tree and must agree; this is
+  /// mostly useful to check that they do.
+  MCDisassembler::DecodeStatus
+  getInstructionFromTable(MCInst &Instr, uint64_t &Size,
+                          ArrayRef<uint8_t> Bytes, uint64_t Address,
+                          raw_ostream &VStream, raw_ostream &CStream) const;
 };
 
 } // namespace llvm
@@ -0,0 +1,42 @@
+; Check that the function index is written, and that it lets the reader
+; materialize a subset of the function bodies.
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=BC
+; RUN: llvm-as < %s | llvm-dis | FileCheck %s -check-prefix=ALL
+; RUN: llvm-as < %s | llvm-dis -materialize-only=0x100004a20,callee \
+; RUN:   | FileCheck %s -check-prefix=ONLY
+; RUN: llvm-as < %s | opt -S -materialize-only=fn_100004A20 \
+; RUN:   | FileCheck %s -check-prefix=OPT
+
+; BC: <FNINDEXOFFSET
+; BC: <FUNCTION_INDEX_BLOCK
+; BC-NEXT: <ENTRY op0=
+; BC-NEXT: <ENTRY op0=
+; BC-NEXT: <ENTRY op0=
+; BC-NEXT: </FUNCTION_INDEX_BLOCK>
+
+; ALL: define i32 @callee(
+; ALL: define i32 @fn_100004A20(
+; ALL: define i32 @fn_100004B00(
+
+; ONLY: define i32 @callee(
+; ONLY: define i32 @fn_100004A20(
+; ONLY: declare i32 @fn_100004B00(
+
+; OPT: declare i32 @callee(
+; OPT: define i32 @fn_100004A20(
+; OPT: declare i32 @fn_100004B00(
+
+define i32 @callee(i32 %a) {
+  %r = add i32 %a, 1
+  ret i32 %r
+}
+
+define i32 @fn_100004A20(i32 %a) {
+  %r = call i32 @callee(i32 %a)
+  ret i32 %r
+}
+
+define i32 @fn_100004B00(i32 %a) {
+  %r = mul i32 %a, %a
+  ret i32 %r
+}
@@ -0,0 +1,61 @@
+; Check that decoding the function blocks on several threads gives the same
+; module as reading them serially.
+; RUN: llvm-as < %s > %t.bc
+; RUN: opt -S %t.bc -o %t.serial.ll
+; RUN: opt -S -bitcode-reader-threads=4 %t.bc -o %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: FileCheck %s < %t.parallel.ll
+
+@table = internal constant [2 x i8*] [i8* blockaddress(@indirect, %a),
+                                      i8* blockaddress(@indirect, %b)]
+
+; CHECK-LABEL: define i64 @fn_100004A20(
+; CHECK: switch i64 %x
+; CHECK: phi i64 [ 42, %entry ], [ %y, %other ]
+define i64 @fn_100004A20(i64 %x) {
+entry:
+  switch i64 %x, label %done [
+    i64 1, label %other
+  ]
+other:
+  %y = call i64 @fn_100004B00(i64 %x), !dbg !7
+  br label %done
+done:
+  %r = phi i64 [ 42, %entry ], [ %y, %other ]
+  ret i64 %r
+}
+
+; CHECK-LABEL: define i64 @fn_100004B00(
+; CHECK: add i64 %x, 81985529216486895
+define i64 @fn_100004B00(i64 %x) {
+  %v = add i64 %x, 81985529216486895
+  %w = fadd double 1.500000e+00, 2.500000e+00
+  %i = fptosi double %w to i64
+  %s = add i64 %v, %i
+  ret i64 %s
+}
+
+; CHECK-LABEL: define i32 @indirect(
+; CHECK: indirectbr i8* %p, [label %a, label %b]
+define i32 @indirect(i32 %i) {
+entry:
+  %gep = getelementptr [2 x i8*], [2 x i8*]* @table, i32 0, i32 %i
+  %p = load i8*, i8** %gep
+  indirectbr i8* %p, [label %a, label %b]
+a:
+  ret i32 1
+b:
+  ret i32 2
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "dc", isOptimized: false, runtimeVersion: 0, emissionKind: 1, subprograms: !4)
+!1 = !DIFile(filename: "a.c", directory: "/")
+!2 = !DISubroutineType(types: !{})
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !{!5}
+!5 = distinct !DISubprogram(name: "fn_100004A20", scope: !1, file: !1, line: 1, type: !2, isLocal: false, isDefinition: true, function: i64 (i64)* @fn_100004A20)
+!6 = !DILocation(line: 2, scope: !5)
+!7 = !DILocation(line: 3, scope: !5, inlinedAt: !6)
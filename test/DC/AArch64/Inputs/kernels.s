@@ -0,0 +1,99 @@
+// Pure-compute kernels for llvm-dc-bench.
+// Regenerate the object with:
+//   llvm-mc -triple=arm64-apple-darwin -filetype=obj kernels.s \
+//     -o kernels.macho-arm64
+
+  .text
+
+// uint32_t fnv1a(const uint8_t *p, uint64_t n)
+  .globl _fnv1a
+  .p2align 2
+_fnv1a:
+  mov w2, #0x9dc5
+  movk w2, #0x811c, lsl #16
+  mov w3, #0x193
+  movk w3, #0x100, lsl #16
+  cbz x1, Lfnv1a_done
+Lfnv1a_loop:
+  ldrb w4, [x0], #1
+  eor w2, w2, w4
+  mul w2, w2, w3
+  subs x1, x1, #1
+  b.ne Lfnv1a_loop
+Lfnv1a_done:
+  mov w0, w2
+  ret
+
+// void copy(uint8_t *dst, const uint8_t *src, uint64_t n)
+  .globl _copy
+  .p2align 2
+_copy:
+  cmp x2, #8
+  b.lo Lcopy_tail
+Lcopy_words:
+  ldr x3, [x1], #8
+  str x3, [x0], #8
+  sub x2, x2, #8
+  cmp x2, #8
+  b.hs Lcopy_words
+Lcopy_tail:
+  cbz x2, Lcopy_done
+Lcopy_bytes:
+  ldrb w3, [x1], #1
+  strb w3, [x0], #1
+  subs x2, x2, #1
+  b.ne Lcopy_bytes
+Lcopy_done:
+  ret
+
+// void sort(uint64_t *a, uint64_t n), insertion sort.
+  .globl _sort
+  .p2align 2
+_sort:
+  cmp x1, #2
+  b.lo Lsort_done
+  mov x2, #1
+Lsort_outer:
+  ldr x3, [x0, x2, lsl #3]
+  mov x4, x2
+Lsort_inner:
+  sub x5, x4, #1
+  ldr x6, [x0, x5, lsl #3]
+  cmp x6, x3
+  b.ls Lsort_insert
+  str x6, [x0, x4, lsl #3]
+  mov x4, x5
+  cbnz x4, Lsort_inner
+Lsort_insert:
+  str x3, [x0, x4, lsl #3]
+  add x2, x2, #1
+  cmp x2, x1
+  b.lo Lsort_outer
+Lsort_done:
+  ret
+
+// uint32_t crc32(const uint8_t *p, uint64_t n), bitwise, reflected
+// polynomial 0xEDB88320.
+  .globl _crc32
+  .p2align 2
+_crc32:
+  mov w2, #-1
+  mov w3, #0x8320
+  movk w3, #0xedb8, lsl #16
+  cbz x1, Lcrc32_done
+Lcrc32_byte:
+  ldrb w4, [x0], #1
+  eor w2, w2, w4
+  mov w5, #8
+Lcrc32_bit:
+  and w6, w2, #1
+  neg w6, w6
+  and w6, w6, w3
+  eor w2, w6, w2, lsr #1
+  subs w5, w5, #1
+  b.ne Lcrc32_bit
+  subs x1, x1, #1
+  b.ne Lcrc32_byte
+Lcrc32_done:
+  mvn w0, w2
+  ret
@@ -0,0 +1,18 @@
+%regset = type { i64, i64, <4 x i32> }
+
+@counter = external global i64
+
+declare void @fn_100001000(%regset*)
+
+define void @fn_100002000(%regset* %regs) {
+  %pc = getelementptr %regset, %regset* %regs, i32 0, i32 0
+  store i64 4294975488, i64* %pc
+  %n = load i64, i64* @counter
+  call void @fn_100001000(%regset* %regs)
+  call void @helper()
+  ret void
+}
+
+define internal void @helper() {
+  ret void
+}
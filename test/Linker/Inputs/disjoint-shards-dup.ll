@@ -0,0 +1,5 @@
+%regset = type { i64, i64, <4 x i32> }
+
+define void @fn_100001000(%regset* %regs) {
+  ret void
+}
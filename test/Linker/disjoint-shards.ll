@@ -0,0 +1,42 @@
+; RUN: llvm-as %s -o %t.a.bc
+; RUN: llvm-as %S/Inputs/disjoint-shards-b.ll -o %t.b.bc
+; RUN: llvm-as %S/Inputs/disjoint-shards-dup.ll -o %t.dup.bc
+; RUN: llvm-link %t.a.bc %t.b.bc -S | FileCheck %s
+; RUN: llvm-link -disjoint-shards %t.a.bc %t.b.bc -S | FileCheck %s
+; RUN: llvm-link -disjoint-shards %t.b.bc %t.a.bc -S | FileCheck %s
+; RUN: not llvm-link -disjoint-shards %t.a.bc %t.dup.bc -S 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=DUP
+
+; Both shards share a single %regset, and each call goes to the definition
+; from the other shard.
+
+; CHECK: %regset = type { i64, i64, <4 x i32> }
+; CHECK-NOT: %regset.
+; CHECK-DAG: @counter = global i64 0
+; CHECK-DAG: define void @fn_100001000(%regset* %regs)
+; CHECK-DAG: call void @fn_100002000(%regset* %regs)
+; CHECK-DAG: define void @fn_100002000(%regset* %regs)
+; CHECK-DAG: call void @fn_100001000(%regset* %regs)
+; CHECK-DAG: define internal void @helper()
+; CHECK-DAG: define internal void @helper.{{[0-9]+}}()
+; CHECK-NOT: declare
+
+; DUP: symbol 'fn_100001000' is defined in more than one shard
+
+%regset = type { i64, i64, <4 x i32> }
+
+@counter = global i64 0
+
+declare void @fn_100002000(%regset*)
+
+define void @fn_100001000(%regset* %regs) {
+  %pc = getelementptr %regset, %regset* %regs, i32 0, i32 0
+  store i64 4294971392, i64* %pc
+  call void @fn_100002000(%regset* %regs)
+  call void @helper()
+  ret void
+}
+
+define internal void @helper() {
+  ret void
+}
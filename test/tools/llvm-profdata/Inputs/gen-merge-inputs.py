@@ -0,0 +1,37 @@
+#!/usr/bin/env python
+
+# Generates COUNT text profiles named <DIR>/<i>.proftext, for the parallel
+# merge test. Most functions have the same number of counters in every
+# profile, but a few of them sometimes disagree, which must be resolved in
+# input order whatever the number of threads.
+#
+# Usage: gen-merge-inputs.py DIR COUNT
+
+import os
+import sys
+
+out_dir = sys.argv[1]
+count = int(sys.argv[2])
+if not os.path.isdir(out_dir):
+    os.makedirs(out_dir)
+
+seed = 12345
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) % (1 << 31)
+    return (seed >> 8) % n
+
+for i in range(count):
+    with open(os.path.join(out_dir, '%d.proftext' % i), 'w') as f:
+        for fn in range(40):
+            if rand(3) == 0:
+                continue
+            hash = 1 + rand(2)
+            counters = 2 + (fn % 4) + hash
+            if fn % 10 == 0 and rand(4) == 0:
+                counters += 1
+            f.write('fn_%x\n%d\n%d\n' % (0x100004000 + fn * 0x20, hash,
+                                         counters))
+            for c in range(counters):
+                f.write('%d\n' % rand(1000))
+            f.write('\n')
@@ -17,6 +17,7 @@
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/CodeGen/DIE.h"
 #include "llvm/Config/config.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugInfoEntry.h"
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
@@ -34,8 +35,11 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/thread.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include <atomic>
+#include <functional>
 #include <string>
 #include <tuple>
 
@@ -1128,15 +1132,18 @@ private:
   unsigned NextValidReloc;
 
   bool findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
-                                  const DebugMapObject &DMO);
+                                  const DebugMapObject &DMO,
+                                  std::vector<ValidReloc> &Relocs) const;
 
   bool findValidRelocs(const object::SectionRef &Section,
                        const object::ObjectFile &Obj,
-                       const DebugMapObject &DMO);
+                       const DebugMapObject &DMO,
+                       std::vector<ValidReloc> &Relocs) const;
 
   void findValidRelocsMachO(const object::SectionRef &Section,
                             const object::MachOObjectFile &Obj,
-                            const DebugMapObject &DMO);
+                            const DebugMapObject &DMO,
+                            std::vector<ValidReloc> &Relocs) const;
   /// @}
 
   /// \defgroup FindRootDIEs Find DIEs corresponding to debug map entries.
@@ -1315,9 +1322,44 @@ private:
   bool createStreamer(Triple TheTriple, StringRef OutputFilename);
 
   /// \brief Attempt to load a debug object from disk.
+  /// \p FoundFile is set to whether the file itself was found: if it isn't,
+  /// BinaryHolder still holds the previously loaded object, which is what
+  /// gets returned.
   ErrorOr<const object::ObjectFile &> loadObject(BinaryHolder &BinaryHolder,
                                                  DebugMapObject &Obj,
-                                                 const DebugMap &Map);
+                                                 const DebugMap &Map,
+                                                 bool &FoundFile) const;
+  /// @}
+
+  /// \defgroup ObjectAnalysis Per-object work that doesn't depend on the
+  /// objects linked before, and can thus run on several threads.
+  ///
+  /// @{
+  struct ObjectAnalysis {
+    /// Owns the object file when the analysis isn't using the linker's
+    /// BinaryHolder.
+    std::unique_ptr<BinaryHolder> OwnBinHolder;
+    const object::ObjectFile *Object;
+    /// Whether the object file was found, see loadObject().
+    bool FoundFile;
+    /// The valid relocations of the debug_info section, sorted by offset.
+    std::vector<ValidReloc> ValidRelocs;
+    /// Only set up if there are valid relocations, with the DIEs of every
+    /// compile unit already extracted.
+    std::unique_ptr<DWARFContextInMemory> DwarfContext;
+
+    ObjectAnalysis() : Object(nullptr), FoundFile(false) {}
+  };
+
+  /// \brief Load \p Obj through \p BinHolder, find its valid
+  /// relocations and parse its debug info.
+  void analyzeObject(BinaryHolder &BinHolder, DebugMapObject &Obj,
+                     const DebugMap &Map, ObjectAnalysis &Analysis) const;
+
+  /// \brief Link the debug info of \p Obj, analyzed in \p Analysis,
+  /// into the output.
+  void linkObject(DebugMapObject &Obj, ObjectAnalysis &Analysis,
+                  uint64_t &OutputDebugInfoSize, unsigned &UnitID);
   /// @}
 
 private:
@@ -1736,7 +1778,8 @@ void DwarfLinker::endDebugObject() {
 /// ValidRelocs array.
 void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
                                        const object::MachOObjectFile &Obj,
-                                       const DebugMapObject &DMO) {
+                                       const DebugMapObject &DMO,
+                                       std::vector<ValidReloc> &Relocs) const {
   StringRef Contents;
   Section.getContents(Contents);
   DataExtractor Data(Contents, Obj.isLittleEndian(), 0);
@@ -1747,7 +1790,8 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
     unsigned RelocSize = 1 << Obj.getAnyRelocationLength(MachOReloc);
     uint64_t Offset64 = Reloc.getOffset();
     if ((RelocSize != 4 && RelocSize != 8)) {
-      reportWarning(" unsupported relocation in debug_info section.");
+      warn(" unsupported relocation in debug_info section.",
+           DMO.getObjectFilename());
       continue;
     }
     uint32_t Offset = Offset64;
@@ -1758,16 +1802,16 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
     if (Sym != Obj.symbol_end()) {
       ErrorOr<StringRef> SymbolName = Sym->getName();
       if (!SymbolName) {
-        reportWarning("error getting relocation symbol name.");
+        warn("error getting relocation symbol name.", DMO.getObjectFilename());
         continue;
       }
       if (const auto *Mapping = DMO.lookupSymbol(*SymbolName))
-        ValidRelocs.emplace_back(Offset64, RelocSize, Addend, Mapping);
+        Relocs.emplace_back(Offset64, RelocSize, Addend, Mapping);
     } else if (const auto *Mapping = DMO.lookupObjectAddress(Addend)) {
       // Do not store the addend. The addend was the address of the
       // symbol in the object file, the address in the binary that is
       // stored in the debug map doesn't need to be offseted.
-      ValidRelocs.emplace_back(Offset64, RelocSize, 0, Mapping);
+      Relocs.emplace_back(Offset64, RelocSize, 0, Mapping);
     }
   }
 }
@@ -1776,21 +1820,23 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
 /// appropriate handler depending on the object file format.
 bool DwarfLinker::findValidRelocs(const object::SectionRef &Section,
                                   const object::ObjectFile &Obj,
-                                  const DebugMapObject &DMO) {
+                                  const DebugMapObject &DMO,
+                                  std::vector<ValidReloc> &Relocs) const {
   // Dispatch to the right handler depending on the file type.
   if (auto *MachOObj = dyn_cast<object::MachOObjectFile>(&Obj))
-    findValidRelocsMachO(Section, *MachOObj, DMO);
+    findValidRelocsMachO(Section, *MachOObj, DMO, Relocs);
   else
-    reportWarning(Twine("unsupported object file type: ") + Obj.getFileName());
+    warn(Twine("unsupported object file type: ") + Obj.getFileName(),
+         DMO.getObjectFilename());
 
-  if (ValidRelocs.empty())
+  if (Relocs.empty())
     return false;
 
   // Sort the relocations by offset. We will walk the DIEs linearly in
   // the file, this allows us to just keep an index in the relocation
   // array that we advance during our walk, rather than resorting to
   // some associative container. See DwarfLinker::NextValidReloc.
-  std::sort(ValidRelocs.begin(), ValidRelocs.end());
+  std::sort(Relocs.begin(), Relocs.end());
   return true;
 }
 
@@ -1799,8 +1845,9 @@ bool DwarfLinker::findValidRelocs(const object::SectionRef &Section,
 /// link by indicating which DIEs refer to symbols present in the
 /// linked binary.
 /// \returns wether there are any valid relocations in the debug info.
-bool DwarfLinker::findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
-                                             const DebugMapObject &DMO) {
+bool DwarfLinker::findValidRelocsInDebugInfo(
+    const object::ObjectFile &Obj, const DebugMapObject &DMO,
+    std::vector<ValidReloc> &Relocs) const {
   // Find the debug_info section.
   for (const object::SectionRef &Section : Obj.sections()) {
     StringRef SectionName;
@@ -1808,7 +1855,7 @@ bool DwarfLinker::findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
     SectionName = SectionName.substr(SectionName.find_first_not_of("._"));
     if (SectionName != "debug_info")
       continue;
-    return findValidRelocs(Section, Obj, DMO);
+    return findValidRelocs(Section, Obj, DMO, Relocs);
   }
   return false;
 }
@@ -2925,17 +2972,125 @@ void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
 
 ErrorOr<const object::ObjectFile &>
 DwarfLinker::loadObject(BinaryHolder &BinaryHolder, DebugMapObject &Obj,
-                        const DebugMap &Map) {
+                        const DebugMap &Map, bool &FoundFile) const {
   auto ErrOrObjs =
       BinaryHolder.GetObjectFiles(Obj.getObjectFilename(), Obj.getTimestamp());
+  FoundFile = bool(ErrOrObjs);
   if (std::error_code EC = ErrOrObjs.getError())
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
+    warn(Twine(Obj.getObjectFilename()) + ": " + EC.message(),
+         Obj.getObjectFilename());
   auto ErrOrObj = BinaryHolder.Get(Map.getTriple());
   if (std::error_code EC = ErrOrObj.getError())
-    reportWarning(Twine(Obj.getObjectFilename()) + ": " + EC.message());
+    warn(Twine(Obj.getObjectFilename()) + ": " + EC.message(),
+         Obj.getObjectFilename());
   return ErrOrObj;
 }
 
+void DwarfLinker::analyzeObject(BinaryHolder &BinHolder, DebugMapObject &Obj,
+                                const DebugMap &Map,
+                                ObjectAnalysis &Analysis) const {
+  auto ErrOrObj = loadObject(BinHolder, Obj, Map, Analysis.FoundFile);
+  if (!ErrOrObj)
+    return;
+  Analysis.Object = &*ErrOrObj;
+
+  // Look for relocations that correspond to debug map entries.
+  if (!findValidRelocsInDebugInfo(*ErrOrObj, Obj, Analysis.ValidRelocs))
+    return;
+
+  // Setup access to the debug info, and extract all of it now, as this is
+  // the expensive part of reading it.
+  Analysis.DwarfContext.reset(new DWARFContextInMemory(*ErrOrObj));
+  for (const auto &CU : Analysis.DwarfContext->compile_units())
+    CU->getUnitDIE(false);
+}
+
+void DwarfLinker::linkObject(DebugMapObject &Obj, ObjectAnalysis &Analysis,
+                             uint64_t &OutputDebugInfoSize, unsigned &UnitID) {
+  CurrentDebugObject = &Obj;
+
+  if (!Analysis.Object)
+    return;
+  if (Analysis.ValidRelocs.empty()) {
+    if (Options.Verbose)
+      outs() << "No valid relocations found. Skipping.\n";
+    return;
+  }
+  ValidRelocs = std::move(Analysis.ValidRelocs);
+
+  DWARFContextInMemory &DwarfContext = *Analysis.DwarfContext;
+  startDebugObject(DwarfContext, Obj);
+
+  // In a first phase, just read in the debug info and store the DIE
+  // parent links that we will use during the next phase.
+  for (const auto &CU : DwarfContext.compile_units()) {
+    auto *CUDie = CU->getUnitDIE(false);
+    if (Options.Verbose) {
+      outs() << "Input compilation unit:";
+      CUDie->dump(outs(), CU.get(), 0);
+    }
+    Units.emplace_back(*CU, UnitID++, !Options.NoODR);
+    gatherDIEParents(CUDie, 0, Units.back(), &ODRContexts.getRoot(),
+                     StringPool, ODRContexts);
+  }
+
+  // Then mark all the DIEs that need to be present in the linked
+  // output and collect some information about them. Note that this
+  // loop can not be merged with the previous one becaue cross-cu
+  // references require the ParentIdx to be setup for every CU in
+  // the object file before calling this.
+  for (auto &CurrentUnit : Units)
+    lookForDIEsToKeep(*CurrentUnit.getOrigUnit().getUnitDIE(), Obj,
+                      CurrentUnit, 0);
+
+  // The calls to applyValidRelocs inside cloneDIE will walk the
+  // reloc array again (in the same way findValidRelocsInDebugInfo()
+  // did). We need to reset the NextValidReloc index to the beginning.
+  NextValidReloc = 0;
+
+  // Construct the output DIE tree by cloning the DIEs we chose to
+  // keep above. If there are no valid relocs, then there's nothing
+  // to clone/emit.
+  if (!ValidRelocs.empty())
+    for (auto &CurrentUnit : Units) {
+      const auto *InputDIE = CurrentUnit.getOrigUnit().getUnitDIE();
+      CurrentUnit.setStartOffset(OutputDebugInfoSize);
+      DIE *OutputDIE = cloneDIE(*InputDIE, CurrentUnit, 0 /* PCOffset */,
+                                11 /* Unit Header size */);
+      CurrentUnit.setOutputUnitDIE(OutputDIE);
+      OutputDebugInfoSize = CurrentUnit.computeNextUnitOffset();
+      if (Options.NoOutput)
+        continue;
+      // FIXME: for compatibility with the classic dsymutil, we emit
+      // an empty line table for the unit, even if the unit doesn't
+      // actually exist in the DIE tree.
+      patchLineTableForUnit(CurrentUnit, DwarfContext);
+      if (!OutputDIE)
+        continue;
+      patchRangesForUnit(CurrentUnit, DwarfContext);
+      Streamer->emitLocationsForUnit(CurrentUnit, DwarfContext);
+      emitAcceleratorEntriesForUnit(CurrentUnit);
+    }
+
+  // Emit all the compile unit's debug information.
+  if (!ValidRelocs.empty() && !Options.NoOutput)
+    for (auto &CurrentUnit : Units) {
+      generateUnitRanges(CurrentUnit);
+      CurrentUnit.fixupForwardReferences();
+      Streamer->emitCompileUnitHeader(CurrentUnit);
+      if (!CurrentUnit.getOutputUnitDIE())
+        continue;
+      Streamer->emitDIE(*CurrentUnit.getOutputUnitDIE());
+    }
+
+  if (!ValidRelocs.empty() && !Options.NoOutput && !Units.empty())
+    patchFrameInfoForObject(Obj, DwarfContext,
+                            Units[0].getOrigUnit().getAddressByteSize());
+
+  // Clean-up before starting working on the next object.
+  endDebugObject();
+}
+
 bool DwarfLinker::link(const DebugMap &Map) {
 
   if (!createStreamer(Map.getTriple(), OutputFilename))
@@ -2945,94 +3100,85 @@ bool DwarfLinker::link(const DebugMap &Map) {
   uint64_t OutputDebugInfoSize = 0;
   // A unique ID that identifies each compile unit.
   unsigned UnitID = 0;
-  for (const auto &Obj : Map.objects()) {
-    CurrentDebugObject = Obj.get();
 
-    if (Options.Verbose)
-      outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
-    auto ErrOrObj = loadObject(BinHolder, *Obj, Map);
-    if (!ErrOrObj)
-      continue;
+  std::vector<DebugMapObject *> Objs;
+  for (const auto &Obj : Map.objects())
+    Objs.push_back(Obj.get());
+
+  unsigned NumThreads = Options.NumThreads;
+#if !LLVM_ENABLE_THREADS
+  NumThreads = 1;
+#endif
 
-    // Look for relocations that correspond to debug map entries.
-    if (!findValidRelocsInDebugInfo(*ErrOrObj, *Obj)) {
+  if (NumThreads <= 1) {
+    for (DebugMapObject *Obj : Objs) {
       if (Options.Verbose)
-        outs() << "No valid relocations found. Skipping.\n";
-      continue;
+        outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
+      ObjectAnalysis Analysis;
+      analyzeObject(BinHolder, *Obj, Map, Analysis);
+      linkObject(*Obj, Analysis, OutputDebugInfoSize, UnitID);
     }
-
-    // Setup access to the debug info.
-    DWARFContextInMemory DwarfContext(*ErrOrObj);
-    startDebugObject(DwarfContext, *Obj);
-
-    // In a first phase, just read in the debug info and store the DIE
-    // parent links that we will use during the next phase.
-    for (const auto &CU : DwarfContext.compile_units()) {
-      auto *CUDie = CU->getUnitDIE(false);
-      if (Options.Verbose) {
-        outs() << "Input compilation unit:";
-        CUDie->dump(outs(), CU.get(), 0);
+  } else {
+#if LLVM_ENABLE_THREADS
+    // The objects are analyzed a window at a time, each with its own
+    // BinaryHolder, while the previous window is linked. The linking itself
+    // (ODR uniquing, string pool, output offsets) stays in debug map order,
+    // which keeps the output identical to the serial one.
+    const size_t WindowSize = 4 * NumThreads;
+    auto analyzeWindow = [&](std::vector<ObjectAnalysis> &Window,
+                             size_t Begin) {
+      size_t End = std::min(Objs.size(), Begin + WindowSize);
+      Window.clear();
+      Window.resize(End - Begin);
+      std::atomic<size_t> Next(Begin);
+      std::vector<std::thread> Threads;
+      for (unsigned T = 0; T != NumThreads; ++T)
+        Threads.emplace_back([&] {
+          for (size_t I = Next++; I < End; I = Next++) {
+            ObjectAnalysis &Analysis = Window[I - Begin];
+            Analysis.OwnBinHolder.reset(new BinaryHolder(false));
+            analyzeObject(*Analysis.OwnBinHolder, *Objs[I], Map, Analysis);
+          }
+        });
+      for (auto &Thread : Threads)
+        Thread.join();
+    };
+
+    // The last object whose file was found, which the serial link would
+    // still hold on to when the next one isn't found.
+    DebugMapObject *LastFound = nullptr;
+    std::vector<ObjectAnalysis> Current, Pending;
+    analyzeWindow(Current, 0);
+    for (size_t Begin = 0; Begin < Objs.size(); Begin += WindowSize) {
+      size_t NextBegin = Begin + WindowSize;
+      std::thread Analyzer;
+      if (NextBegin < Objs.size())
+        Analyzer = std::thread(analyzeWindow, std::ref(Pending), NextBegin);
+      for (size_t I = Begin, E = Begin + Current.size(); I != E; ++I) {
+        if (Options.Verbose)
+          outs() << "DEBUG MAP OBJECT: " << Objs[I]->getObjectFilename()
+                 << "\n";
+        ObjectAnalysis &Analysis = Current[I - Begin];
+        if (Analysis.FoundFile) {
+          LastFound = Objs[I];
+        } else if (LastFound) {
+          // Reproduce the serial behavior by reloading the previous object
+          // in the linker's BinaryHolder and analyzing this one from there.
+          BinHolder.GetObjectFiles(LastFound->getObjectFilename(),
+                                   LastFound->getTimestamp());
+          Analysis = ObjectAnalysis();
+          analyzeObject(BinHolder, *Objs[I], Map, Analysis);
+        }
+        linkObject(*Objs[I], Analysis, OutputDebugInfoSize, UnitID);
+        // Release the debug info and the object file as soon as possible.
+        Analysis.DwarfContext.reset();
+        Analysis.OwnBinHolder.reset();
       }
-      Units.emplace_back(*CU, UnitID++, !Options.NoODR);
-      gatherDIEParents(CUDie, 0, Units.back(), &ODRContexts.getRoot(),
-                       StringPool, ODRContexts);
+      if (Analyzer.joinable())
+        Analyzer.join();
+      std::swap(Current, Pending);
     }
-
-    // Then mark all the DIEs that need to be present in the linked
-    // output and collect some information about them. Note that this
-    // loop can not be merged with the previous one becaue cross-cu
-    // references require the ParentIdx to be setup for every CU in
-    // the object file before calling this.
-    for (auto &CurrentUnit : Units)
-      lookForDIEsToKeep(*CurrentUnit.getOrigUnit().getUnitDIE(), *Obj,
-                        CurrentUnit, 0);
-
-    // The calls to applyValidRelocs inside cloneDIE will walk the
-    // reloc array again (in the same way findValidRelocsInDebugInfo()
-    // did). We need to reset the NextValidReloc index to the beginning.
-    NextValidReloc = 0;
-
-    // Construct the output DIE tree by cloning the DIEs we chose to
-    // keep above. If there are no valid relocs, then there's nothing
-    // to clone/emit.
-    if (!ValidRelocs.empty())
-      for (auto &CurrentUnit : Units) {
-        const auto *InputDIE = CurrentUnit.getOrigUnit().getUnitDIE();
-        CurrentUnit.setStartOffset(OutputDebugInfoSize);
-        DIE *OutputDIE = cloneDIE(*InputDIE, CurrentUnit, 0 /* PCOffset */,
-                                  11 /* Unit Header size */);
-        CurrentUnit.setOutputUnitDIE(OutputDIE);
-        OutputDebugInfoSize = CurrentUnit.computeNextUnitOffset();
-        if (Options.NoOutput)
-          continue;
-        // FIXME: for compatibility with the classic dsymutil, we emit
-        // an empty line table for the unit, even if the unit doesn't
-        // actually exist in the DIE tree.
-        patchLineTableForUnit(CurrentUnit, DwarfContext);
-        if (!OutputDIE)
-          continue;
-        patchRangesForUnit(CurrentUnit, DwarfContext);
-        Streamer->emitLocationsForUnit(CurrentUnit, DwarfContext);
-        emitAcceleratorEntriesForUnit(CurrentUnit);
-      }
-
-    // Emit all the compile unit's debug information.
-    if (!ValidRelocs.empty() && !Options.NoOutput)
-      for (auto &CurrentUnit : Units) {
-        generateUnitRanges(CurrentUnit);
-        CurrentUnit.fixupForwardReferences();
-        Streamer->emitCompileUnitHeader(CurrentUnit);
-        if (!CurrentUnit.getOutputUnitDIE())
-          continue;
-        Streamer->emitDIE(*CurrentUnit.getOutputUnitDIE());
-      }
-
-    if (!ValidRelocs.empty() && !Options.NoOutput && !Units.empty())
-      patchFrameInfoForObject(*Obj, DwarfContext,
-                              Units[0].getOrigUnit().getAddressByteSize());
-
-    // Clean-up before starting working on the next object.
-    endDebugObject();
+#endif
   }
 
   // Emit everything that's global.
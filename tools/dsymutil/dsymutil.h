@@ -28,8 +28,9 @@ struct LinkOptions {
   bool Verbose;  ///< Verbosity
   bool NoOutput; ///< Skip emitting output
   bool NoODR;    ///< Do not unique types according to ODR
+  unsigned NumThreads; ///< Threads to use for the per-object analysis
 
-  LinkOptions() : Verbose(false), NoOutput(false) {}
+  LinkOptions() : Verbose(false), NoOutput(false), NumThreads(1) {}
 };
 
 /// \brief Extract the DebugMaps from the given file.
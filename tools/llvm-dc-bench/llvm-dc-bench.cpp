@@ -0,0 +1,726 @@
+//===-- llvm-dc-bench.cpp - Benchmark DC-translated code ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This tool measures the quality of the code DC emits, rather than how fast
+// it translates.
+//
+// It translates the compute kernels of an object file at each TransOpt level,
+// JITs the result on the host, and runs each kernel against an emulated
+// register set and stack, with reproducible inputs. The results are checked
+// against a host reference implementation of the kernel, and the time per
+// iteration is reported.
+//
+// Guest memory accesses are done directly in the host address space, so the
+// guest and host both need to be 64-bit little-endian.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "llvm-dc-bench"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/DC/DCInstrSema.h"
+#include "llvm/DC/DCRegisterSema.h"
+#include "llvm/DC/DCTranslator.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
+#include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/MC/MCAnalysis/MCFunction.h"
+#include "llvm/MC/MCAnalysis/MCModule.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler.h"
+#include "llvm/MC/MCInstPrinter.h"
+#include "llvm/MC/MCInstrAnalysis.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectDisassembler.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+using namespace llvm;
+using namespace object;
+using namespace orc;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::desc("<input object files>"),
+               cl::OneOrMore);
+
+static cl::opt<std::string>
+TripleName("triple", cl::desc("Target triple to disassemble for, "
+                              "see -version for available targets"));
+
+static cl::list<std::string>
+Kernels("kernel",
+        cl::desc("Kernel to run, as <kind>[=<symbol>]; the symbol defaults "
+                 "to the kind. Kinds: fnv1a, crc32, copy, sort "
+                 "(default = every function named after a kind)"),
+        cl::CommaSeparated);
+
+static cl::list<unsigned>
+OptLevels("opt-levels",
+          cl::desc("TransOpt levels to run the kernels at (default = 0,1,2,3)"),
+          cl::CommaSeparated);
+
+static cl::opt<unsigned>
+Iterations("iterations", cl::desc("Number of timed runs of each kernel"),
+           cl::init(1000));
+
+static cl::opt<unsigned>
+InputSize("size", cl::desc("Size in bytes of the kernel inputs"),
+          cl::init(4096));
+
+static cl::opt<unsigned>
+Seed("seed", cl::desc("Seed for the kernel inputs"), cl::init(0x5eed));
+
+static cl::opt<bool>
+CheckOnly("check-only",
+          cl::desc("Only check the kernel results, don't time them"),
+          cl::init(false));
+
+static cl::opt<bool>
+TranslationStats("translation-stats",
+                 cl::desc("Don't run anything; report the translation time "
+                          "and the size of the translated IR of all the "
+                          "functions of the inputs, per TransOpt level"),
+                 cl::init(false));
+
+static StringRef ToolName;
+
+namespace {
+
+/// The MC and DC target objects needed to translate an object file.
+struct DCTargetInfo {
+  std::string TripleName;
+  const Target *TheTarget;
+  std::unique_ptr<const MCRegisterInfo> MRI;
+  std::unique_ptr<const MCAsmInfo> MAI;
+  std::unique_ptr<const MCSubtargetInfo> STI;
+  std::unique_ptr<const MCInstrInfo> MII;
+  std::unique_ptr<const MCObjectFileInfo> MOFI;
+  std::unique_ptr<MCContext> Ctx;
+  std::unique_ptr<MCDisassembler> DisAsm;
+  std::unique_ptr<MCInstPrinter> MIP;
+  std::unique_ptr<const MCInstrAnalysis> MIA;
+  std::unique_ptr<MCObjectDisassembler> OD;
+  std::unique_ptr<MCModule> MCM;
+
+  /// Set up the target for \p Obj, and build its MCModule.
+  bool init(const ObjectFile &Obj);
+
+  /// Create a translator for the MCModule, and its register and instruction
+  /// semas, at optimization level \p Lvl.
+  std::unique_ptr<DCTranslator>
+  createTranslator(TransOpt::Level Lvl, const DataLayout &DL,
+                   std::unique_ptr<DCRegisterSema> &DRS,
+                   std::unique_ptr<DCInstrSema> &DIS);
+};
+
+} // end anonymous namespace
+
+bool DCTargetInfo::init(const ObjectFile &Obj) {
+  // Figure out the target triple.
+  Triple TheTriple("unknown-unknown-unknown");
+  if (::TripleName.empty()) {
+    TheTriple.setArch(Triple::ArchType(Obj.getArch()));
+    // TheTriple defaults to ELF, and COFF doesn't have an environment:
+    // the best we can do here is indicate that it is mach-o.
+    if (Obj.isMachO())
+      TheTriple.setObjectFormat(Triple::MachO);
+  } else {
+    TheTriple.setTriple(::TripleName);
+  }
+
+  // Get the Target.
+  std::string Error;
+  TheTarget = TargetRegistry::lookupTarget("", TheTriple, Error);
+  if (!TheTarget) {
+    errs() << ToolName << ": " << Error;
+    return false;
+  }
+  TripleName = TheTriple.getTriple();
+
+  MRI.reset(TheTarget->createMCRegInfo(TripleName));
+  if (!MRI) {
+    errs() << "error: no register info for target " << TripleName << "\n";
+    return false;
+  }
+
+  // Set up disassembler.
+  MAI.reset(TheTarget->createMCAsmInfo(*MRI, TripleName));
+  if (!MAI) {
+    errs() << "error: no assembly info for target " << TripleName << "\n";
+    return false;
+  }
+
+  STI.reset(TheTarget->createMCSubtargetInfo(TripleName, "", ""));
+  if (!STI) {
+    errs() << "error: no subtarget info for target " << TripleName << "\n";
+    return false;
+  }
+
+  MII.reset(TheTarget->createMCInstrInfo());
+  if (!MII) {
+    errs() << "error: no instruction info for target " << TripleName << "\n";
+    return false;
+  }
+
+  MOFI.reset(new MCObjectFileInfo);
+  Ctx.reset(new MCContext(MAI.get(), MRI.get(), MOFI.get()));
+
+  DisAsm.reset(TheTarget->createMCDisassembler(*STI, *Ctx));
+  if (!DisAsm) {
+    errs() << "error: no disassembler for target " << TripleName << "\n";
+    return false;
+  }
+
+  MIP.reset(
+      TheTarget->createMCInstPrinter(Triple(TripleName), 0, *MAI, *MII, *MRI));
+  if (!MIP) {
+    errs() << "error: no instprinter for target " << TripleName << "\n";
+    return false;
+  }
+
+  MIA.reset(TheTarget->createMCInstrAnalysis(MII.get()));
+
+  OD.reset(new MCObjectDisassembler(Obj, *DisAsm, *MIA));
+  MCM.reset(OD->buildModule());
+  return MCM != nullptr;
+}
+
+std::unique_ptr<DCTranslator>
+DCTargetInfo::createTranslator(TransOpt::Level Lvl, const DataLayout &DL,
+                               std::unique_ptr<DCRegisterSema> &DRS,
+                               std::unique_ptr<DCInstrSema> &DIS) {
+  DRS.reset(TheTarget->createDCRegisterSema(TripleName, *MRI, *MII, DL));
+  if (!DRS) {
+    errs() << "error: no dc register sema for target " << TripleName << "\n";
+    return nullptr;
+  }
+  DIS.reset(TheTarget->createDCInstrSema(TripleName, *DRS, *MRI, *MII));
+  if (!DIS) {
+    errs() << "error: no dc instruction sema for target " << TripleName
+           << "\n";
+    return nullptr;
+  }
+  return make_unique<DCTranslator>(getGlobalContext(), DL, Lvl, *DIS, *DRS,
+                                   *MIP, *STI, *MCM, OD.get());
+}
+
+template <typename T>
+static std::vector<T> singletonSet(T t) {
+  std::vector<T> Vec;
+  Vec.push_back(std::move(t));
+  return Vec;
+}
+
+namespace {
+
+/// A JIT for the modules of a single DCTranslator.
+/// Every TransOpt level gets its own, as they all define the same functions.
+class BenchJIT {
+public:
+  typedef ObjectLinkingLayer<> ObjLayerT;
+  typedef IRCompileLayer<ObjLayerT> CompileLayerT;
+
+  BenchJIT(TargetMachine &TM)
+      : DL(TM.createDataLayout()),
+        CompileLayer(ObjectLayer, SimpleCompiler(TM)) {}
+
+  void addModule(Module *M) {
+    DEBUG(M->dump());
+    auto Resolver = createLambdaResolver(
+        [&](const std::string &Name) {
+          if (auto Sym = CompileLayer.findSymbol(Name, true))
+            return RuntimeDyld::SymbolInfo(Sym.getAddress(), Sym.getFlags());
+          else if (auto Addr =
+                       RTDyldMemoryManager::getSymbolAddressInProcess(Name))
+            return RuntimeDyld::SymbolInfo(Addr, JITSymbolFlags::Exported);
+          return RuntimeDyld::SymbolInfo(nullptr);
+        },
+        [](const std::string &S) { return nullptr; });
+
+    CompileLayer.addModuleSet(singletonSet(std::move(M)),
+                              make_unique<SectionMemoryManager>(),
+                              std::move(Resolver));
+  }
+
+  TargetAddress getFunctionAddress(StringRef Name) {
+    std::string MangledName;
+    {
+      raw_string_ostream MangledNameStream(MangledName);
+      Mangler::getNameWithPrefix(MangledNameStream, Name, DL);
+    }
+    return CompileLayer.findSymbol(MangledName, true).getAddress();
+  }
+
+private:
+  const DataLayout DL;
+  ObjLayerT ObjectLayer;
+  CompileLayerT CompileLayer;
+};
+
+/// The guest side of a compute kernel, and its host reference.
+/// Kernels take their arguments in X0-X7, and return their result in X0.
+class Kernel {
+public:
+  enum { MaxArgs = 8 };
+
+  virtual ~Kernel() {}
+
+  /// Build the input for a \p Size bytes problem, and the expected output.
+  virtual void init(std::mt19937_64 &RNG, size_t Size) = 0;
+
+  /// Restore the buffers the kernel writes to, and set the arguments.
+  virtual void reset(uint64_t (&Args)[MaxArgs]) = 0;
+
+  /// \returns true if the result and the written buffers match the host
+  /// reference.
+  virtual bool check(uint64_t Result) const = 0;
+
+  static std::unique_ptr<Kernel> create(StringRef Kind);
+};
+
+template <typename T> static uint64_t toArg(T *Ptr) {
+  return reinterpret_cast<uintptr_t>(Ptr);
+}
+
+static std::vector<uint8_t> randomBytes(std::mt19937_64 &RNG, size_t Size) {
+  std::vector<uint8_t> Bytes(Size);
+  for (uint8_t &B : Bytes)
+    B = RNG();
+  return Bytes;
+}
+
+/// Hashes of a byte buffer: uint32_t hash(const uint8_t *p, uint64_t n).
+class HashKernel : public Kernel {
+  uint32_t (*Reference)(const uint8_t *, size_t);
+  std::vector<uint8_t> Data;
+  uint32_t Expected;
+
+public:
+  HashKernel(uint32_t (*Reference)(const uint8_t *, size_t))
+      : Reference(Reference), Expected(0) {}
+
+  void init(std::mt19937_64 &RNG, size_t Size) override {
+    Data = randomBytes(RNG, Size);
+    Expected = Reference(Data.data(), Data.size());
+  }
+  void reset(uint64_t (&Args)[MaxArgs]) override {
+    Args[0] = toArg(Data.data());
+    Args[1] = Data.size();
+  }
+  bool check(uint64_t Result) const override {
+    return uint32_t(Result) == Expected;
+  }
+};
+
+static uint32_t fnv1a(const uint8_t *P, size_t N) {
+  uint32_t H = 0x811c9dc5;
+  for (size_t i = 0; i != N; ++i)
+    H = (H ^ P[i]) * 0x01000193;
+  return H;
+}
+
+static uint32_t crc32(const uint8_t *P, size_t N) {
+  uint32_t C = ~0U;
+  for (size_t i = 0; i != N; ++i) {
+    C ^= P[i];
+    for (unsigned b = 0; b != 8; ++b)
+      C = (C >> 1) ^ (0xEDB88320 & -(C & 1));
+  }
+  return ~C;
+}
+
+/// void copy(uint8_t *dst, const uint8_t *src, uint64_t n)
+class CopyKernel : public Kernel {
+  std::vector<uint8_t> Src, Dst;
+
+public:
+  void init(std::mt19937_64 &RNG, size_t Size) override {
+    Src = randomBytes(RNG, Size);
+    Dst.assign(Size, 0);
+  }
+  void reset(uint64_t (&Args)[MaxArgs]) override {
+    std::fill(Dst.begin(), Dst.end(), 0);
+    Args[0] = toArg(Dst.data());
+    Args[1] = toArg(Src.data());
+    Args[2] = Src.size();
+  }
+  bool check(uint64_t Result) const override { return Dst == Src; }
+};
+
+/// void sort(uint64_t *a, uint64_t n), in ascending order.
+class SortKernel : public Kernel {
+  std::vector<uint64_t> Input, Work, Expected;
+
+public:
+  void init(std::mt19937_64 &RNG, size_t Size) override {
+    Input.resize(Size / sizeof(uint64_t));
+    for (uint64_t &V : Input)
+      V = RNG();
+    Expected = Input;
+    std::sort(Expected.begin(), Expected.end());
+  }
+  void reset(uint64_t (&Args)[MaxArgs]) override {
+    Work = Input;
+    Args[0] = toArg(Work.data());
+    Args[1] = Work.size();
+  }
+  bool check(uint64_t Result) const override { return Work == Expected; }
+};
+
+std::unique_ptr<Kernel> Kernel::create(StringRef Kind) {
+  if (Kind == "fnv1a")
+    return make_unique<HashKernel>(fnv1a);
+  if (Kind == "crc32")
+    return make_unique<HashKernel>(crc32);
+  if (Kind == "copy")
+    return make_unique<CopyKernel>();
+  if (Kind == "sort")
+    return make_unique<SortKernel>();
+  return nullptr;
+}
+
+struct KernelInfo {
+  std::string Kind;
+  uint64_t Addr;
+  std::unique_ptr<Kernel> K;
+};
+
+} // end anonymous namespace
+
+static const char *getTransOptName(TransOpt::Level Lvl) {
+  switch (Lvl) {
+  case TransOpt::None: return "None";
+  case TransOpt::Less: return "Less";
+  case TransOpt::Default: return "Default";
+  case TransOpt::Aggressive: return "Aggressive";
+  }
+  llvm_unreachable("Unknown TransOpt level!");
+}
+
+static unsigned findRegister(const MCRegisterInfo &MRI, StringRef Name) {
+  for (unsigned Reg = 1, e = MRI.getNumRegs(); Reg != e; ++Reg)
+    if (Name == MRI.getName(Reg))
+      return Reg;
+  return 0;
+}
+
+// Find the kernels to run in the symbol table of \p Obj.
+static bool findKernels(const ObjectFile &Obj,
+                        std::vector<KernelInfo> &Infos) {
+  StringMap<uint64_t> Functions;
+  for (const SymbolRef &Symbol : Obj.symbols()) {
+    if (Symbol.getType() != SymbolRef::ST_Function)
+      continue;
+    ErrorOr<StringRef> NameOrErr = Symbol.getName();
+    ErrorOr<uint64_t> AddrOrErr = Symbol.getAddress();
+    if (NameOrErr.getError() || AddrOrErr.getError())
+      continue;
+    StringRef Name = *NameOrErr;
+    // Accept both the C and the assembly names.
+    Functions[Name] = *AddrOrErr;
+    if (Obj.isMachO() && Name.startswith("_"))
+      Functions[Name.substr(1)] = *AddrOrErr;
+  }
+
+  std::vector<std::pair<std::string, std::string>> Requested;
+  for (StringRef Spec : Kernels) {
+    std::pair<StringRef, StringRef> KindSym = Spec.split('=');
+    if (KindSym.second.empty())
+      KindSym.second = KindSym.first;
+    Requested.push_back(std::make_pair(KindSym.first.str(),
+                                       KindSym.second.str()));
+  }
+  if (Requested.empty())
+    for (const char *Kind : {"fnv1a", "crc32", "copy", "sort"})
+      if (Functions.count(Kind))
+        Requested.push_back(std::make_pair(Kind, Kind));
+
+  for (const auto &KindSym : Requested) {
+    KernelInfo Info;
+    Info.Kind = KindSym.first;
+    Info.K = Kernel::create(Info.Kind);
+    if (!Info.K) {
+      errs() << ToolName << ": unknown kernel kind '" << Info.Kind << "'\n";
+      return false;
+    }
+    auto FI = Functions.find(KindSym.second);
+    if (FI == Functions.end()) {
+      errs() << ToolName << ": no function '" << KindSym.second
+             << "' in '" << Obj.getFileName() << "'\n";
+      return false;
+    }
+    Info.Addr = FI->second;
+    Infos.push_back(std::move(Info));
+  }
+  return true;
+}
+
+static uint64_t countInstructions(const Module &M, unsigned &NumFunctions) {
+  uint64_t NumInsts = 0;
+  for (const Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    ++NumFunctions;
+    for (const BasicBlock &BB : F)
+      NumInsts += BB.size();
+  }
+  return NumInsts;
+}
+
+// Translate every known function of every input, at each level, and report
+// how long it took, and how big the result is.
+static bool reportTranslationStats(ArrayRef<TransOpt::Level> Levels,
+                                   ArrayRef<const ObjectFile *> Objs) {
+  std::vector<std::unique_ptr<DCTargetInfo>> Targets;
+  for (const ObjectFile *Obj : Objs) {
+    Targets.emplace_back(new DCTargetInfo);
+    if (!Targets.back()->init(*Obj))
+      return false;
+  }
+
+  // FIXME: should we have a non-default datalayout? see llvm-dec.
+  DataLayout DL("");
+
+  outs() << "Level      Functions Instructions    Time (ms)\n";
+  for (TransOpt::Level Lvl : Levels) {
+    unsigned NumFunctions = 0;
+    uint64_t NumInsts = 0;
+    std::chrono::steady_clock::duration Total(0);
+    for (auto &T : Targets) {
+      std::unique_ptr<DCRegisterSema> DRS;
+      std::unique_ptr<DCInstrSema> DIS;
+      auto Start = std::chrono::steady_clock::now();
+      std::unique_ptr<DCTranslator> DT = T->createTranslator(Lvl, DL, DRS, DIS);
+      if (!DT)
+        return false;
+      DT->translateAllKnownFunctions();
+      Total += std::chrono::steady_clock::now() - Start;
+      NumInsts +=
+          countInstructions(*DT->getCurrentTranslationModule(), NumFunctions);
+    }
+    outs() << format("%-10s %9u %12llu %12.2f\n", getTransOptName(Lvl),
+                     NumFunctions, (unsigned long long)NumInsts,
+                     std::chrono::duration<double, std::milli>(Total).count());
+  }
+  return true;
+}
+
+// Run the kernels of \p Obj on the host, at each level, and report whether
+// they computed the right result, and how long they took.
+static bool runKernels(ArrayRef<TransOpt::Level> Levels,
+                       const ObjectFile &Obj) {
+  // Guest addresses are host addresses.
+  if (!sys::IsLittleEndianHost || sizeof(void *) != 8 ||
+      !Obj.isLittleEndian() || Obj.getBytesInAddress() != 8) {
+    errs() << ToolName << ": only 64-bit little-endian guests are supported, "
+           << "on 64-bit little-endian hosts\n";
+    return false;
+  }
+
+  std::vector<KernelInfo> KernelInfos;
+  if (!findKernels(Obj, KernelInfos))
+    return false;
+
+  DCTargetInfo T;
+  if (!T.init(Obj))
+    return false;
+
+  // Argument and result registers, by name, to stay target-independent.
+  unsigned ArgRegs[Kernel::MaxArgs];
+  for (unsigned i = 0; i != Kernel::MaxArgs; ++i) {
+    ArgRegs[i] = findRegister(*T.MRI, "X" + utostr(i));
+    if (!ArgRegs[i]) {
+      errs() << "error: no argument registers for target " << T.TripleName
+             << "\n";
+      return false;
+    }
+  }
+
+  std::unique_ptr<TargetMachine> TM(EngineBuilder().selectTarget());
+  if (!TM) {
+    errs() << "error: unable to select the host target machine\n";
+    return false;
+  }
+  const DataLayout DL = TM->createDataLayout();
+
+  if (sys::DynamicLibrary::LoadLibraryPermanently(nullptr)) {
+    errs() << "error: unable to load program symbols.\n";
+    return false;
+  }
+
+  std::mt19937_64 RNG(Seed);
+  for (KernelInfo &Info : KernelInfos)
+    Info.K->init(RNG, InputSize);
+
+  const unsigned StackSize = 1024 * 1024;
+  std::vector<uint8_t> Stack(StackSize);
+
+  bool AllOK = true;
+  for (TransOpt::Level Lvl : Levels) {
+    std::unique_ptr<DCRegisterSema> DRS;
+    std::unique_ptr<DCInstrSema> DIS;
+    std::unique_ptr<DCTranslator> DT = T.createTranslator(Lvl, DL, DRS, DIS);
+    if (!DT)
+      return false;
+    DT->translateAllKnownFunctions();
+    Function *InitRegSetFn = DT->getInitRegSetFunction();
+    BenchJIT J(*TM);
+    J.addModule(DT->finalizeTranslationModule());
+
+    // 64byte alignment ought to be enough for anybody, see
+    // DCInstrSema::getOrCreateMainFunction.
+    const StructLayout *SL = DL.getStructLayout(DRS->getRegSetType());
+    std::vector<uint8_t> RegSetStorage(SL->getSizeInBytes() + 64);
+    uint8_t *RegSet = reinterpret_cast<uint8_t *>(
+        alignAddr(RegSetStorage.data(), 64));
+
+    auto InitRegSetFP =
+        (void (*)(uint8_t *, uint8_t *, uint32_t, uint32_t, char **))
+          (intptr_t)J.getFunctionAddress(InitRegSetFn->getName());
+
+    auto writeReg = [&](unsigned Reg, uint64_t Val) {
+      size_t Size, Offset;
+      std::tie(Size, Offset) = DRS->getRegSizeOffsetInRegSet(Reg);
+      memcpy(RegSet + Offset, &Val, std::min(Size, sizeof(Val)));
+    };
+    auto readReg = [&](unsigned Reg) {
+      size_t Size, Offset;
+      std::tie(Size, Offset) = DRS->getRegSizeOffsetInRegSet(Reg);
+      uint64_t Val = 0;
+      memcpy(&Val, RegSet + Offset, std::min(Size, sizeof(Val)));
+      return Val;
+    };
+
+    for (KernelInfo &Info : KernelInfos) {
+      auto KernelFP = (void (*)(uint8_t *))(intptr_t)J.getFunctionAddress(
+          "fn_" + utohexstr(Info.Addr));
+      if (!KernelFP) {
+        errs() << ToolName << ": kernel '" << Info.Kind
+               << "' wasn't translated\n";
+        return false;
+      }
+
+      auto reset = [&]() {
+        uint64_t Args[Kernel::MaxArgs] = {};
+        Info.K->reset(Args);
+        std::fill(RegSetStorage.begin(), RegSetStorage.end(), 0);
+        InitRegSetFP(RegSet, Stack.data(), StackSize, 0, nullptr);
+        for (unsigned i = 0; i != Kernel::MaxArgs; ++i)
+          writeReg(ArgRegs[i], Args[i]);
+      };
+
+      // The first run isn't timed, and is the one checked.
+      reset();
+      KernelFP(RegSet);
+      bool OK = Info.K->check(readReg(ArgRegs[0]));
+      AllOK &= OK;
+
+      outs() << format("%-8s %-10s ", Info.Kind.c_str(), getTransOptName(Lvl));
+      if (!CheckOnly) {
+        std::chrono::steady_clock::duration Total(0);
+        for (unsigned i = 0; i != Iterations; ++i) {
+          reset();
+          auto Start = std::chrono::steady_clock::now();
+          KernelFP(RegSet);
+          Total += std::chrono::steady_clock::now() - Start;
+        }
+        double NS =
+            std::chrono::duration<double, std::nano>(Total).count() /
+            std::max(1U, unsigned(Iterations));
+        outs() << format("%12.1f ns/iter ", NS);
+      }
+      outs() << (OK ? "ok" : "MISMATCH") << "\n";
+    }
+  }
+
+  return AllOK;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+
+  InitializeNativeTarget();
+  InitializeNativeTargetAsmPrinter();
+  InitializeAllTargetInfos();
+  InitializeAllTargetDCs();
+  InitializeAllTargetMCs();
+  InitializeAllAsmParsers();
+  InitializeAllDisassemblers();
+
+  cl::ParseCommandLineOptions(argc, argv, "DC translated code benchmark\n");
+
+  ToolName = argv[0];
+
+  std::vector<TransOpt::Level> Levels;
+  for (unsigned Lvl : OptLevels) {
+    if (Lvl > TransOpt::Aggressive) {
+      errs() << ToolName << ": invalid optimization level.\n";
+      return 1;
+    }
+    Levels.push_back(TransOpt::Level(Lvl));
+  }
+  if (Levels.empty())
+    Levels = {TransOpt::None, TransOpt::Less, TransOpt::Default,
+              TransOpt::Aggressive};
+
+  if (!TranslationStats && InputFilenames.size() != 1) {
+    errs() << ToolName << ": kernels can only be run from a single input\n";
+    return 1;
+  }
+
+  std::vector<OwningBinary<Binary>> Binaries;
+  std::vector<const ObjectFile *> Objs;
+  for (const std::string &InputFilename : InputFilenames) {
+    auto BinaryOrErr = createBinary(InputFilename);
+    if (std::error_code ec = BinaryOrErr.getError()) {
+      errs() << ToolName << ": '" << InputFilename << "': "
+             << ec.message() << ".\n";
+      return 1;
+    }
+    Binaries.push_back(std::move(*BinaryOrErr));
+
+    const ObjectFile *Obj = dyn_cast<ObjectFile>(Binaries.back().getBinary());
+    if (!Obj) {
+      errs() << ToolName << ": '" << InputFilename << "': "
+             << "Unrecognized file type.\n";
+      return 1;
+    }
+    Objs.push_back(Obj);
+  }
+
+  if (TranslationStats)
+    return reportTranslationStats(Levels, Objs) ? 0 : 1;
+  return runKernels(Levels, *Objs.front()) ? 0 : 1;
+}
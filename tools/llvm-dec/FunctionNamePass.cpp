@@ -155,29 +155,24 @@ bool FunctionNamePass::runOnModule(Module &M) {
 }
 
 void FunctionNamePass::resolveSymbols() {
-    bool hasStubsSection = false;
+    section_iterator Stubs = MachO->findSection("", "__stubs");
+    bool hasStubsSection = Stubs != MachO->section_end();
     SectionRef StubsSection;
     SectionRef StubHelperSection;
     SectionRef LazyPtrSection;
     SectionRef TextSection;
 
-    for (section_iterator i = MachO->section_begin(); i != MachO->section_end(); ++i) {
-
-        StringRef Name;
-        i->getName(Name);
-
-        if (Name == "__stubs") {
-            StubsSection = *i;
-            hasStubsSection = true;
-        } else if (Name == "__stub_helper") {
-            StubHelperSection = *i;
-        } else if (Name == "__la_symbol_ptr") {
-            LazyPtrSection = *i;
-        } else if (Name == "__text") {
-            TextSection = *i;
-        }
-    }
-
+    if (hasStubsSection)
+        StubsSection = *Stubs;
+    section_iterator StubHelper = MachO->findSection("", "__stub_helper");
+    if (StubHelper != MachO->section_end())
+        StubHelperSection = *StubHelper;
+    section_iterator LazyPtr = MachO->findSection("", "__la_symbol_ptr");
+    if (LazyPtr != MachO->section_end())
+        LazyPtrSection = *LazyPtr;
+    section_iterator Text = MachO->findSection("", "__text");
+    if (Text != MachO->section_end())
+        TextSection = *Text;
 
     if (!hasStubsSection) {
         return;
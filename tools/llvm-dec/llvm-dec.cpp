@@ -2,6 +2,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/DC/DCInstrSema.h"
+#include "llvm/DC/DCReadOnlyImage.h"
 #include "llvm/DC/DCRegisterSema.h"
 #include "llvm/DC/DCTranslator.h"
 #include "llvm/MC/MCAsmInfo.h"
@@ -55,6 +56,24 @@ static cl::opt<bool>
 AnnotateIROutput("annot", cl::desc("Enable IR output anotations"),
                  cl::init(false));
 
+static cl::opt<DCAnnotationWriter::AnnotationFormat>
+AnnotFormat("annot-format", cl::desc("IR output annotation format"),
+            cl::init(DCAnnotationWriter::Full),
+            cl::values(
+              clEnumValN(DCAnnotationWriter::Full, "full",
+                         "Print the instruction with every annotated value"),
+              clEnumValN(DCAnnotationWriter::Compact, "compact",
+                         "Print the instruction once per group of values"),
+              clEnumValN(DCAnnotationWriter::AddressOnly, "address",
+                         "Only print the instruction address"),
+              clEnumValEnd));
+
+static cl::opt<std::string>
+AnnotTableFilename("annot-table",
+                   cl::desc("Write an address to instruction text table for "
+                            "the IR output annotations"),
+                   cl::value_desc("filename"));
+
 static cl::opt<bool>
         NoPrint("no-print", cl::desc("Do not print the produced source"),
                          cl::init(false));
@@ -74,8 +93,15 @@ EnableDisassemblyCache("enable-mcod-disass-cache",
     cl::desc("Enable the MC Object disassembly instruction cache"),
     cl::init(false), cl::Hidden);
 
+static cl::opt<bool>
+FoldReadOnlyLoads("fold-ro-loads",
+    cl::desc("Fold loads from read-only data (literal pools, __const, ...) "
+             "to the loaded constant"),
+    cl::init(false));
+
 static cl::opt<std::string>
-        OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
+        OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"),
+                       cl::init("-"));
 
 static StringRef ToolName;
 
@@ -238,6 +264,12 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  std::unique_ptr<DCReadOnlyImage> ROImage;
+  if (FoldReadOnlyLoads) {
+    ROImage = DCReadOnlyImage::create(*Obj);
+    DIS->setReadOnlyImage(ROImage.get());
+  }
+
   std::unique_ptr<DCTranslator> DT(
     new DCTranslator(getGlobalContext(), DL,
                      TOLvl, *DIS, *DRS, *MIP, *STI, *MCM,
@@ -262,6 +294,9 @@ int main(int argc, char **argv) {
         pm->run(*DT->getCurrentTranslationModule());
     }
 
+    if (DCAnnotationWriter *AW = DT->getAnnotationWriter())
+      AW->setFormat(AnnotFormat);
+
     if (!NoPrint) {
         std::error_code EC;
         sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
@@ -277,13 +312,28 @@ int main(int argc, char **argv) {
         if (PrintBitcode) {
             WriteBitcodeToFile(DT->getCurrentTranslationModule(), FDOut->os(), true);
         } else {
-            FDOut->os() << *DT->getCurrentTranslationModule();
+            DT->printCurrentModule(FDOut->os());
         }
 
         FDOut->keep();
-        //DT->printCurrentModule(FDOut->os());
 
 
     }
+
+    if (!AnnotTableFilename.empty()) {
+      DCAnnotationWriter *AW = DT->getAnnotationWriter();
+      if (!AW) {
+        errs() << ToolName << ": -annot-table requires -annot\n";
+        return 1;
+      }
+      std::error_code EC;
+      tool_output_file TableOut(AnnotTableFilename, EC, sys::fs::F_Text);
+      if (EC) {
+        errs() << EC.message() << '\n';
+        return 1;
+      }
+      AW->writeInstTable(TableOut.os());
+      TableOut.keep();
+    }
   return 0;
 }
@@ -54,6 +54,12 @@ static cl::opt<bool>
 ShowAnnotations("show-annotations",
                 cl::desc("Add informational comments to the .ll file"));
 
+static cl::list<std::string> MaterializeOnly(
+    "materialize-only", cl::CommaSeparated,
+    cl::desc("Only disassemble the bodies of these functions; 0x<addr> "
+             "selects the function translated from that address"),
+    cl::value_desc("function|0xaddr,..."));
+
 static cl::opt<bool> PreserveAssemblyUseListOrder(
     "preserve-ll-uselistorder",
     cl::desc("Preserve use-list order when writing LLVM assembly."),
@@ -147,10 +153,26 @@ int main(int argc, char **argv) {
   std::string ErrorMessage;
   std::unique_ptr<Module> M;
 
-  // Use the bitcode streaming interface
-  std::unique_ptr<DataStreamer> Streamer =
-      getDataFileStreamer(InputFilename, &ErrorMessage);
-  if (Streamer) {
+  if (!MaterializeOnly.empty()) {
+    // Read lazily from memory, so that the function index lets us go straight
+    // to the requested bodies.
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFileOrSTDIN(InputFilename);
+    if (std::error_code EC = BufOrErr.getError()) {
+      errs() << argv[0] << ": " << EC.message() << '\n';
+      return 1;
+    }
+    ErrorOr<std::unique_ptr<Module>> MOrErr =
+        getLazyBitcodeModule(std::move(*BufOrErr), Context);
+    M = std::move(*MOrErr);
+    std::vector<std::string> Missing;
+    materializeFunctionsOnly(*M, MaterializeOnly, Missing);
+    for (const std::string &Name : Missing)
+      errs() << argv[0] << ": warning: no function '" << Name << "'\n";
+    M->materializeAllPermanently();
+  } else if (std::unique_ptr<DataStreamer> Streamer =
+                 getDataFileStreamer(InputFilename, &ErrorMessage)) {
+    // Use the bitcode streaming interface
     std::string DisplayFilename;
     if (InputFilename == "-")
       DisplayFilename = "<stdin>";
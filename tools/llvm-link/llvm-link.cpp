@@ -25,6 +25,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
@@ -60,6 +61,11 @@ Verbose("v", cl::desc("Print information about actions taken"));
 static cl::opt<bool>
 DumpAsm("d", cl::desc("Print assembly as linked"), cl::Hidden);
 
+static cl::opt<bool> DisjointShards(
+    "disjoint-shards",
+    cl::desc("Inputs are shards of the same program, defining disjoint sets "
+             "of symbols: move their definitions instead of mapping them"));
+
 static cl::opt<bool>
 SuppressWarnings("suppress-warnings", cl::desc("Suppress all linking warnings"),
                  cl::init(false));
@@ -81,9 +87,35 @@ static std::unique_ptr<Module>
 loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
   SMDiagnostic Err;
   if (Verbose) errs() << "Loading '" << FN << "'\n";
-  std::unique_ptr<Module> Result = getLazyIRFileModule(FN, Err, Context);
-  if (!Result)
+  std::unique_ptr<Module> Result;
+  if (DisjointShards) {
+    // Share the named types of the shards, so that they can be moved as is.
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+        MemoryBuffer::getFileOrSTDIN(FN);
+    if (std::error_code EC = BufOrErr.getError()) {
+      errs() << argv0 << ": " << FN << ": " << EC.message() << '\n';
+      return nullptr;
+    }
+    if (isBitcode((const unsigned char *)(*BufOrErr)->getBufferStart(),
+                  (const unsigned char *)(*BufOrErr)->getBufferEnd())) {
+      ErrorOr<std::unique_ptr<Module>> MOrErr = getLazyBitcodeModule(
+          std::move(*BufOrErr), Context, nullptr,
+          /*ShouldLazyLoadMetadata=*/false, /*ShouldReuseNamedTypes=*/true);
+      if (std::error_code EC = MOrErr.getError()) {
+        errs() << argv0 << ": " << FN << ": " << EC.message() << '\n';
+        return nullptr;
+      }
+      Result = std::move(*MOrErr);
+    } else {
+      Result = parseIR((*BufOrErr)->getMemBufferRef(), Err, Context);
+    }
+  } else {
+    Result = getLazyIRFileModule(FN, Err, Context);
+  }
+  if (!Result) {
     Err.print(argv0, errs());
+    return nullptr;
+  }
 
   Result->materializeMetadata();
   UpgradeDebugInfo(*Result);
@@ -130,8 +162,12 @@ static bool linkFiles(const char *argv0, LLVMContext &Context, Linker &L,
     if (Verbose)
       errs() << "Linking in '" << File << "'\n";
 
-    if (L.linkInModule(M.get(), OverrideDuplicateSymbols))
+    if (DisjointShards && !OverrideDuplicateSymbols) {
+      if (L.linkDisjointShards(M.get()))
+        return false;
+    } else if (L.linkInModule(M.get(), OverrideDuplicateSymbols)) {
       return false;
+    }
   }
 
   return true;
@@ -19,6 +19,7 @@
 #include "llvm/MC/MCAnalysis/MCFunction.h"
 #include "llvm/MC/MCAnalysis/MCModule.h"
 #include "llvm/MC/MCAnalysis/MCModuleYAML.h"
+#include "llvm/MC/MCAnalysis/MCObjectSymbolizer.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCDisassembler.h"
@@ -85,6 +86,10 @@ static cl::opt<bool>
 EmitDOT("emit-dot", cl::desc("Write the CFG for every function found in the"
                              "object to a graphviz .dot file"));
 
+static cl::opt<bool>
+Symbolize("symbolize", cl::desc("When disassembling instructions, "
+                                 "try to symbolize operands."));
+
 static cl::opt<bool>
 EnableDisassemblyCache("enable-mcod-disass-cache",
     cl::desc("Enable the MC Object disassembly instruction cache"),
@@ -130,10 +135,11 @@ struct DOTMCFunction {
   const MCFunction &Fn;
   MCInstPrinter &IP;
   const MCSubtargetInfo &STI;
+  MCObjectSymbolizer *MOS;
 
   DOTMCFunction(const MCFunction &Fn, MCInstPrinter &IP,
-                const MCSubtargetInfo &STI)
-      : Fn(Fn), IP(IP), STI(STI) {}
+                const MCSubtargetInfo &STI, MCObjectSymbolizer *MOS)
+      : Fn(Fn), IP(IP), STI(STI), MOS(MOS) {}
 };
 
 namespace llvm {
@@ -183,6 +189,9 @@ struct DOTGraphTraits<DOTMCFunction> : public DefaultDOTGraphTraits {
     std::string OutStr;
     raw_string_ostream Out(OutStr);
     for (auto DInst : *BB) {
+      if (MCFN.MOS)
+        MCFN.MOS->materializeSymbolicOperands(DInst.Inst, DInst.Address,
+                                              *MCFN.Fn.getParent());
       MCFN.IP.printInst(&DInst.Inst, Out, "", MCFN.STI);
       Out << '\n';
     }
@@ -195,7 +204,8 @@ struct DOTGraphTraits<DOTMCFunction> : public DefaultDOTGraphTraits {
 // Write a graphviz file for the CFG inside an MCFunction.
 // FIXME: Use GraphWriter
 static void emitDOTFile(const char *FileName, const MCFunction &f,
-                        MCInstPrinter *IP, const MCSubtargetInfo &STI) {
+                        MCInstPrinter *IP, const MCSubtargetInfo &STI,
+                        MCObjectSymbolizer *MOS) {
   // Start a new dot file.
   std::error_code EC;
 
@@ -205,7 +215,7 @@ static void emitDOTFile(const char *FileName, const MCFunction &f,
     errs() << ToolName << ": warning: " << EC.message() << '\n';
     return;
   }
-  DOTMCFunction DOTFn(f, *IP, STI);
+  DOTMCFunction DOTFn(f, *IP, STI, MOS);
   WriteGraph(Out, DOTFn);
 
 #if 0
@@ -306,6 +316,28 @@ static void DumpObject(const ObjectFile *Obj) {
     return;
   }
 
+  // The symbolizer is plugged into the disassembler in compact mode: the
+  // symbolic operands are kept in the module, and their expressions are only
+  // built when printing the instructions.
+  MCObjectSymbolizer *MOS = nullptr;
+  if (Symbolize) {
+    std::unique_ptr<MCRelocationInfo> RelInfo(
+        TheTarget->createMCRelocationInfo(TripleName, Ctx));
+    if (!RelInfo) {
+      errs() << "error: no relocation info for target " << TripleName << "\n";
+      return;
+    }
+    std::unique_ptr<MCObjectSymbolizer> Symbolizer(
+        TheTarget->createMCObjectSymbolizer(Ctx, *Obj, std::move(RelInfo)));
+    if (!Symbolizer) {
+      errs() << "error: no object symbolizer for target " << TripleName << "\n";
+      return;
+    }
+    MOS = Symbolizer.get();
+    MOS->setCompactOperands(true);
+    DisAsm->setSymbolizer(std::move(Symbolizer));
+  }
+
   std::unique_ptr<MCDisassembler> DisAsmImpl;
   if (EnableDisassemblyCache) {
     DisAsmImpl = std::move(DisAsm);
@@ -326,6 +358,7 @@ static void DumpObject(const ObjectFile *Obj) {
 
   std::unique_ptr<MCObjectDisassembler> OD(
       new MCObjectDisassembler(*Obj, *DisAsm, *MIA));
+  OD->setSymbolizer(MOS);
   std::unique_ptr<MCModule> Mod(OD->buildModule());
   if (EmitDOT) {
     for (MCModule::const_func_iterator FI = Mod->func_begin(),
@@ -334,7 +367,7 @@ static void DumpObject(const ObjectFile *Obj) {
       static int filenum = 0;
       emitDOTFile((Twine((*FI)->getName()) + "_" +
                    utostr(filenum) + ".dot").str().c_str(),
-                  **FI, IP.get(), *STI);
+                  **FI, IP.get(), *STI, MOS);
       ++filenum;
     }
   }
@@ -13,6 +13,7 @@
 
 #include "llvm-objdump.h"
 #include "llvm-c/Disassembler.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
@@ -45,6 +46,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
+#include <set>
 #include <system_error>
 
 #if HAVE_CXXABI_H
@@ -1679,6 +1681,251 @@ typedef std::pair<uint64_t, const char *> BindInfoEntry;
 typedef std::vector<BindInfoEntry> BindTable;
 typedef BindTable::iterator bind_table_iterator;
 
+namespace {
+// AddressIntervals maps addresses to the first of a list of entries whose
+// [Begin, Begin + Size) range contains them, the way a linear walk over the
+// entries in the order they were added would.
+template <typename T> class AddressIntervals {
+  struct Interval {
+    uint64_t Begin, End;
+    unsigned Idx;
+  };
+  std::vector<std::pair<uint64_t, uint64_t>> Ranges;
+  std::vector<T> Entries;
+  // Sorted and disjoint.
+  std::vector<Interval> Intervals;
+
+public:
+  void add(uint64_t Begin, uint64_t Size, const T &Entry) {
+    if (Size == 0)
+      return;
+    Ranges.push_back(std::make_pair(Begin, Begin + Size));
+    Entries.push_back(Entry);
+  }
+
+  // Must be called once all the entries are added, before any lookup.
+  void finalize() {
+    // Sweep the range boundaries, keeping the set of entries covering the
+    // current position. The one that was added first wins.
+    std::vector<std::pair<uint64_t, unsigned>> Starts, Ends;
+    for (unsigned i = 0, e = Ranges.size(); i != e; ++i) {
+      Starts.push_back(std::make_pair(Ranges[i].first, i));
+      Ends.push_back(std::make_pair(Ranges[i].second, i));
+    }
+    std::sort(Starts.begin(), Starts.end());
+    std::sort(Ends.begin(), Ends.end());
+    std::set<unsigned> Active;
+    auto SI = Starts.begin(), SE = Starts.end();
+    auto EI = Ends.begin(), EE = Ends.end();
+    while (SI != SE || EI != EE) {
+      uint64_t Pos = EI->first;
+      if (SI != SE && SI->first < Pos)
+        Pos = SI->first;
+      for (; EI != EE && EI->first == Pos; ++EI)
+        Active.erase(EI->second);
+      for (; SI != SE && SI->first == Pos; ++SI)
+        Active.insert(SI->second);
+      if (!Intervals.empty() && Intervals.back().End == ~0ULL)
+        Intervals.back().End = Pos;
+      if (Active.empty())
+        continue;
+      unsigned Idx = *Active.begin();
+      if (!Intervals.empty() && Intervals.back().End == Pos &&
+          Intervals.back().Idx == Idx) {
+        Intervals.back().End = ~0ULL;
+        continue;
+      }
+      Interval I = {Pos, ~0ULL, Idx};
+      Intervals.push_back(I);
+    }
+    Ranges.clear();
+  }
+
+  const T *lookup(uint64_t Addr) const {
+    auto I = std::upper_bound(
+        Intervals.begin(), Intervals.end(), Addr,
+        [](uint64_t A, const Interval &I) { return A < I.Begin; });
+    if (I == Intervals.begin())
+      return nullptr;
+    --I;
+    if (Addr >= I->End)
+      return nullptr;
+    return &Entries[I->Idx];
+  }
+};
+
+// MachOAddressIndex is built once per object file, and answers the address
+// queries of the symbolizer call backs and of the Objective-C meta data
+// printers without walking the load commands or sections again.
+class MachOAddressIndex {
+public:
+  struct SectionData {
+    uint64_t Addr;
+    uint64_t Size;
+    uint32_t Offset;
+    uint32_t FirstIndirectSym;
+    uint32_t Stride;
+    enum { None, SelRef, ClassRef, MsgRef, CFString } ObjCKind;
+  };
+
+  MachOAddressIndex(MachOObjectFile *O, const std::vector<SectionRef> &Sections)
+      : O(O) {
+    for (const auto &Load : O->load_commands()) {
+      if (Load.C.cmd == MachO::LC_SEGMENT_64) {
+        MachO::segment_command_64 Seg = O->getSegment64LoadCommand(Load);
+        for (unsigned J = 0; J < Seg.nsects; ++J) {
+          MachO::section_64 Sec = O->getSection64(Load, J);
+          addSection(Sec.sectname, Sec.addr, Sec.size, Sec.offset, Sec.flags,
+                     Sec.reserved1, Sec.reserved2, 8, true);
+        }
+      } else if (Load.C.cmd == MachO::LC_SEGMENT) {
+        MachO::segment_command Seg = O->getSegmentLoadCommand(Load);
+        for (unsigned J = 0; J < Seg.nsects; ++J) {
+          MachO::section Sec = O->getSection(Load, J);
+          addSection(Sec.sectname, Sec.addr, Sec.size, Sec.offset, Sec.flags,
+                     Sec.reserved1, Sec.reserved2, 4, false);
+        }
+      }
+    }
+    CstringSections.finalize();
+    IndirectSections.finalize();
+    ObjCPointerSections.finalize();
+
+    for (const SectionRef &Section : Sections) {
+      AllSections.add(Section.getAddress(), Section.getSize(), Section);
+      StringRef SectName;
+      Section.getName(SectName);
+      StringRef SegName =
+          O->getSectionFinalSegmentName(Section.getRawDataRefImpl());
+      if (SegName == "__OBJC" || SectName == "__cstring")
+        ObjCSections.add(Section.getAddress(), Section.getSize(), Section);
+    }
+    AllSections.finalize();
+    ObjCSections.finalize();
+
+    if (O->getDysymtabLoadCommand().nindirectsyms)
+      IndirectSymbolNames.resize(O->getDysymtabLoadCommand().nindirectsyms,
+                                 nullptr);
+  }
+
+  // The S_CSTRING_LITERALS section containing Addr.
+  const SectionData *findCstringSection(uint64_t Addr) const {
+    return CstringSections.lookup(Addr);
+  }
+  // The symbol pointer or stub section containing Addr.
+  const SectionData *findIndirectSection(uint64_t Addr) const {
+    return IndirectSections.lookup(Addr);
+  }
+  // The Objective-C reference or cfstring section containing Addr, 64-bit
+  // segments only.
+  const SectionData *findObjCPointerSection(uint64_t Addr) const {
+    return ObjCPointerSections.lookup(Addr);
+  }
+  // The section containing Addr, among all of them or only the __OBJC
+  // segment and __cstring sections.
+  const SectionRef *findSection(uint64_t Addr, bool ObjCOnly) const {
+    return ObjCOnly ? ObjCSections.lookup(Addr) : AllSections.lookup(Addr);
+  }
+
+  // The name of the symbol at Index in the indirect symbol table, or nullptr.
+  const char *getIndirectSymbolName(uint32_t Index) {
+    if (Index >= IndirectSymbolNames.size())
+      return nullptr;
+    const char *&Name = IndirectSymbolNames[Index];
+    if (Name)
+      return Name == NoName ? nullptr : Name;
+    Name = NoName;
+    uint32_t indirect_symbol =
+        O->getIndirectSymbolTableEntry(O->getDysymtabLoadCommand(), Index);
+    if (indirect_symbol < O->getSymtabLoadCommand().nsyms) {
+      symbol_iterator Sym = O->getSymbolByIndex(indirect_symbol);
+      SymbolRef Symbol = *Sym;
+      ErrorOr<StringRef> SymName = Symbol.getName();
+      if (std::error_code EC = SymName.getError())
+        report_fatal_error(EC.message());
+      Name = SymName->data();
+    }
+    return Name == NoName ? nullptr : Name;
+  }
+
+  // The first non-scattered relocation of S at Offset, if any.
+  bool findPlainRelocation(SectionRef S, uint64_t Offset,
+                           RelocationRef &Reloc) {
+    auto &Relocs = SectionRelocs[S.getRawDataRefImpl().d.a];
+    if (!Relocs.second) {
+      for (const RelocationRef &R : S.relocations())
+        if (!O->isRelocationScattered(O->getRelocation(R.getRawDataRefImpl())))
+          Relocs.first.push_back(std::make_pair(R.getOffset(), R));
+      std::stable_sort(Relocs.first.begin(), Relocs.first.end(),
+                       [](const std::pair<uint64_t, RelocationRef> &LHS,
+                          const std::pair<uint64_t, RelocationRef> &RHS) {
+        return LHS.first < RHS.first;
+      });
+      Relocs.second = true;
+    }
+    auto I = std::lower_bound(
+        Relocs.first.begin(), Relocs.first.end(), Offset,
+        [](const std::pair<uint64_t, RelocationRef> &R, uint64_t Offset) {
+          return R.first < Offset;
+        });
+    if (I == Relocs.first.end() || I->first != Offset)
+      return false;
+    Reloc = I->second;
+    return true;
+  }
+
+private:
+  MachOObjectFile *O;
+  AddressIntervals<SectionData> CstringSections;
+  AddressIntervals<SectionData> IndirectSections;
+  AddressIntervals<SectionData> ObjCPointerSections;
+  AddressIntervals<SectionRef> AllSections;
+  AddressIntervals<SectionRef> ObjCSections;
+  // Filled in on demand; NoName marks the entries that have no name.
+  std::vector<const char *> IndirectSymbolNames;
+  static const char NoName[];
+  // The plain relocations of each section sorted by offset, once computed.
+  DenseMap<uint64_t,
+           std::pair<std::vector<std::pair<uint64_t, RelocationRef>>, bool>>
+      SectionRelocs;
+
+  void addSection(const char *SectName, uint64_t Addr, uint64_t Size,
+                  uint32_t Offset, uint32_t Flags, uint32_t Reserved1,
+                  uint32_t Reserved2, uint32_t PointerSize, bool Is64) {
+    SectionData Data = {Addr, Size, Offset, Reserved1, PointerSize,
+                        SectionData::None};
+    uint32_t section_type = Flags & MachO::SECTION_TYPE;
+    if (section_type == MachO::S_CSTRING_LITERALS)
+      CstringSections.add(Addr, Size, Data);
+    if (section_type == MachO::S_NON_LAZY_SYMBOL_POINTERS ||
+        section_type == MachO::S_LAZY_SYMBOL_POINTERS ||
+        section_type == MachO::S_LAZY_DYLIB_SYMBOL_POINTERS ||
+        section_type == MachO::S_THREAD_LOCAL_VARIABLE_POINTERS ||
+        section_type == MachO::S_SYMBOL_STUBS) {
+      if (section_type == MachO::S_SYMBOL_STUBS)
+        Data.Stride = Reserved2;
+      IndirectSections.add(Addr, Size, Data);
+    }
+    if (!Is64)
+      return;
+    if (strncmp(SectName, "__objc_selrefs", 16) == 0)
+      Data.ObjCKind = SectionData::SelRef;
+    else if (strncmp(SectName, "__objc_classrefs", 16) == 0 ||
+             strncmp(SectName, "__objc_superrefs", 16) == 0)
+      Data.ObjCKind = SectionData::ClassRef;
+    else if (strncmp(SectName, "__objc_msgrefs", 16) == 0)
+      Data.ObjCKind = SectionData::MsgRef;
+    else if (strncmp(SectName, "__cfstring", 16) == 0)
+      Data.ObjCKind = SectionData::CFString;
+    else
+      return;
+    ObjCPointerSections.add(Addr, Size, Data);
+  }
+};
+
+const char MachOAddressIndex::NoName[] = "";
+}
+
 // The block of info used by the Symbolizer call backs.
 struct DisassembleInfo {
   bool verbose;
@@ -1686,6 +1933,7 @@ struct DisassembleInfo {
   SectionRef S;
   SymbolAddressMap *AddrMap;
   std::vector<SectionRef> *Sections;
+  MachOAddressIndex *Index;
   const char *class_name;
   const char *selector_name;
   char *method;
@@ -2087,52 +2335,20 @@ static int SymbolizerGetOpInfo(void *DisInfo, uint64_t Pc, uint64_t Offset,
 // it returns a pointer to that string.  Else it returns nullptr.
 static const char *GuessCstringPointer(uint64_t ReferenceValue,
                                        struct DisassembleInfo *info) {
-  for (const auto &Load : info->O->load_commands()) {
-    if (Load.C.cmd == MachO::LC_SEGMENT_64) {
-      MachO::segment_command_64 Seg = info->O->getSegment64LoadCommand(Load);
-      for (unsigned J = 0; J < Seg.nsects; ++J) {
-        MachO::section_64 Sec = info->O->getSection64(Load, J);
-        uint32_t section_type = Sec.flags & MachO::SECTION_TYPE;
-        if (section_type == MachO::S_CSTRING_LITERALS &&
-            ReferenceValue >= Sec.addr &&
-            ReferenceValue < Sec.addr + Sec.size) {
-          uint64_t sect_offset = ReferenceValue - Sec.addr;
-          uint64_t object_offset = Sec.offset + sect_offset;
-          StringRef MachOContents = info->O->getData();
-          uint64_t object_size = MachOContents.size();
-          const char *object_addr = (const char *)MachOContents.data();
-          if (object_offset < object_size) {
-            const char *name = object_addr + object_offset;
-            return name;
-          } else {
-            return nullptr;
-          }
-        }
-      }
-    } else if (Load.C.cmd == MachO::LC_SEGMENT) {
-      MachO::segment_command Seg = info->O->getSegmentLoadCommand(Load);
-      for (unsigned J = 0; J < Seg.nsects; ++J) {
-        MachO::section Sec = info->O->getSection(Load, J);
-        uint32_t section_type = Sec.flags & MachO::SECTION_TYPE;
-        if (section_type == MachO::S_CSTRING_LITERALS &&
-            ReferenceValue >= Sec.addr &&
-            ReferenceValue < Sec.addr + Sec.size) {
-          uint64_t sect_offset = ReferenceValue - Sec.addr;
-          uint64_t object_offset = Sec.offset + sect_offset;
-          StringRef MachOContents = info->O->getData();
-          uint64_t object_size = MachOContents.size();
-          const char *object_addr = (const char *)MachOContents.data();
-          if (object_offset < object_size) {
-            const char *name = object_addr + object_offset;
-            return name;
-          } else {
-            return nullptr;
-          }
-        }
-      }
-    }
+  const auto *Sec = info->Index->findCstringSection(ReferenceValue);
+  if (!Sec)
+    return nullptr;
+  uint64_t sect_offset = ReferenceValue - Sec->Addr;
+  uint64_t object_offset = Sec->Offset + sect_offset;
+  StringRef MachOContents = info->O->getData();
+  uint64_t object_size = MachOContents.size();
+  const char *object_addr = (const char *)MachOContents.data();
+  if (object_offset < object_size) {
+    const char *name = object_addr + object_offset;
+    return name;
+  } else {
+    return nullptr;
   }
-  return nullptr;
 }
 
 // GuessIndirectSymbol returns the name of the indirect symbol for the
@@ -2141,82 +2357,12 @@ static const char *GuessCstringPointer(uint64_t ReferenceValue,
 // symbol name being referenced by the stub or pointer.
 static const char *GuessIndirectSymbol(uint64_t ReferenceValue,
                                        struct DisassembleInfo *info) {
-  MachO::dysymtab_command Dysymtab = info->O->getDysymtabLoadCommand();
-  MachO::symtab_command Symtab = info->O->getSymtabLoadCommand();
-  for (const auto &Load : info->O->load_commands()) {
-    if (Load.C.cmd == MachO::LC_SEGMENT_64) {
-      MachO::segment_command_64 Seg = info->O->getSegment64LoadCommand(Load);
-      for (unsigned J = 0; J < Seg.nsects; ++J) {
-        MachO::section_64 Sec = info->O->getSection64(Load, J);
-        uint32_t section_type = Sec.flags & MachO::SECTION_TYPE;
-        if ((section_type == MachO::S_NON_LAZY_SYMBOL_POINTERS ||
-             section_type == MachO::S_LAZY_SYMBOL_POINTERS ||
-             section_type == MachO::S_LAZY_DYLIB_SYMBOL_POINTERS ||
-             section_type == MachO::S_THREAD_LOCAL_VARIABLE_POINTERS ||
-             section_type == MachO::S_SYMBOL_STUBS) &&
-            ReferenceValue >= Sec.addr &&
-            ReferenceValue < Sec.addr + Sec.size) {
-          uint32_t stride;
-          if (section_type == MachO::S_SYMBOL_STUBS)
-            stride = Sec.reserved2;
-          else
-            stride = 8;
-          if (stride == 0)
-            return nullptr;
-          uint32_t index = Sec.reserved1 + (ReferenceValue - Sec.addr) / stride;
-          if (index < Dysymtab.nindirectsyms) {
-            uint32_t indirect_symbol =
-                info->O->getIndirectSymbolTableEntry(Dysymtab, index);
-            if (indirect_symbol < Symtab.nsyms) {
-              symbol_iterator Sym = info->O->getSymbolByIndex(indirect_symbol);
-              SymbolRef Symbol = *Sym;
-              ErrorOr<StringRef> SymName = Symbol.getName();
-              if (std::error_code EC = SymName.getError())
-                report_fatal_error(EC.message());
-              const char *name = SymName->data();
-              return name;
-            }
-          }
-        }
-      }
-    } else if (Load.C.cmd == MachO::LC_SEGMENT) {
-      MachO::segment_command Seg = info->O->getSegmentLoadCommand(Load);
-      for (unsigned J = 0; J < Seg.nsects; ++J) {
-        MachO::section Sec = info->O->getSection(Load, J);
-        uint32_t section_type = Sec.flags & MachO::SECTION_TYPE;
-        if ((section_type == MachO::S_NON_LAZY_SYMBOL_POINTERS ||
-             section_type == MachO::S_LAZY_SYMBOL_POINTERS ||
-             section_type == MachO::S_LAZY_DYLIB_SYMBOL_POINTERS ||
-             section_type == MachO::S_THREAD_LOCAL_VARIABLE_POINTERS ||
-             section_type == MachO::S_SYMBOL_STUBS) &&
-            ReferenceValue >= Sec.addr &&
-            ReferenceValue < Sec.addr + Sec.size) {
-          uint32_t stride;
-          if (section_type == MachO::S_SYMBOL_STUBS)
-            stride = Sec.reserved2;
-          else
-            stride = 4;
-          if (stride == 0)
-            return nullptr;
-          uint32_t index = Sec.reserved1 + (ReferenceValue - Sec.addr) / stride;
-          if (index < Dysymtab.nindirectsyms) {
-            uint32_t indirect_symbol =
-                info->O->getIndirectSymbolTableEntry(Dysymtab, index);
-            if (indirect_symbol < Symtab.nsyms) {
-              symbol_iterator Sym = info->O->getSymbolByIndex(indirect_symbol);
-              SymbolRef Symbol = *Sym;
-              ErrorOr<StringRef> SymName = Symbol.getName();
-              if (std::error_code EC = SymName.getError())
-                report_fatal_error(EC.message());
-              const char *name = SymName->data();
-              return name;
-            }
-          }
-        }
-      }
-    }
-  }
-  return nullptr;
+  const auto *Sec = info->Index->findIndirectSection(ReferenceValue);
+  if (!Sec || Sec->Stride == 0)
+    return nullptr;
+  uint32_t index =
+      Sec->FirstIndirectSym + (ReferenceValue - Sec->Addr) / Sec->Stride;
+  return info->Index->getIndirectSymbolName(index);
 }
 
 // method_reference() is called passing it the ReferenceName that might be
@@ -2301,53 +2447,36 @@ static uint64_t GuessPointerPointer(uint64_t ReferenceValue,
   selref = false;
   msgref = false;
   cfstring = false;
-  for (const auto &Load : info->O->load_commands()) {
-    if (Load.C.cmd == MachO::LC_SEGMENT_64) {
-      MachO::segment_command_64 Seg = info->O->getSegment64LoadCommand(Load);
-      for (unsigned J = 0; J < Seg.nsects; ++J) {
-        MachO::section_64 Sec = info->O->getSection64(Load, J);
-        if ((strncmp(Sec.sectname, "__objc_selrefs", 16) == 0 ||
-             strncmp(Sec.sectname, "__objc_classrefs", 16) == 0 ||
-             strncmp(Sec.sectname, "__objc_superrefs", 16) == 0 ||
-             strncmp(Sec.sectname, "__objc_msgrefs", 16) == 0 ||
-             strncmp(Sec.sectname, "__cfstring", 16) == 0) &&
-            ReferenceValue >= Sec.addr &&
-            ReferenceValue < Sec.addr + Sec.size) {
-          uint64_t sect_offset = ReferenceValue - Sec.addr;
-          uint64_t object_offset = Sec.offset + sect_offset;
-          StringRef MachOContents = info->O->getData();
-          uint64_t object_size = MachOContents.size();
-          const char *object_addr = (const char *)MachOContents.data();
-          if (object_offset < object_size) {
-            uint64_t pointer_value;
-            memcpy(&pointer_value, object_addr + object_offset,
-                   sizeof(uint64_t));
-            if (info->O->isLittleEndian() != sys::IsLittleEndianHost)
-              sys::swapByteOrder(pointer_value);
-            if (strncmp(Sec.sectname, "__objc_selrefs", 16) == 0)
-              selref = true;
-            else if (strncmp(Sec.sectname, "__objc_classrefs", 16) == 0 ||
-                     strncmp(Sec.sectname, "__objc_superrefs", 16) == 0)
-              classref = true;
-            else if (strncmp(Sec.sectname, "__objc_msgrefs", 16) == 0 &&
-                     ReferenceValue + 8 < Sec.addr + Sec.size) {
-              msgref = true;
-              memcpy(&pointer_value, object_addr + object_offset + 8,
-                     sizeof(uint64_t));
-              if (info->O->isLittleEndian() != sys::IsLittleEndianHost)
-                sys::swapByteOrder(pointer_value);
-            } else if (strncmp(Sec.sectname, "__cfstring", 16) == 0)
-              cfstring = true;
-            return pointer_value;
-          } else {
-            return 0;
-          }
-        }
-      }
-    }
-    // TODO: Look for LC_SEGMENT for 32-bit Mach-O files.
+  const auto *Sec = info->Index->findObjCPointerSection(ReferenceValue);
+  if (!Sec)
+    return 0;
+  uint64_t sect_offset = ReferenceValue - Sec->Addr;
+  uint64_t object_offset = Sec->Offset + sect_offset;
+  StringRef MachOContents = info->O->getData();
+  uint64_t object_size = MachOContents.size();
+  const char *object_addr = (const char *)MachOContents.data();
+  if (object_offset < object_size) {
+    uint64_t pointer_value;
+    memcpy(&pointer_value, object_addr + object_offset, sizeof(uint64_t));
+    if (info->O->isLittleEndian() != sys::IsLittleEndianHost)
+      sys::swapByteOrder(pointer_value);
+    if (Sec->ObjCKind == MachOAddressIndex::SectionData::SelRef)
+      selref = true;
+    else if (Sec->ObjCKind == MachOAddressIndex::SectionData::ClassRef)
+      classref = true;
+    else if (Sec->ObjCKind == MachOAddressIndex::SectionData::MsgRef &&
+             ReferenceValue + 8 < Sec->Addr + Sec->Size) {
+      msgref = true;
+      memcpy(&pointer_value, object_addr + object_offset + 8,
+             sizeof(uint64_t));
+      if (info->O->isLittleEndian() != sys::IsLittleEndianHost)
+        sys::swapByteOrder(pointer_value);
+    } else if (Sec->ObjCKind == MachOAddressIndex::SectionData::CFString)
+      cfstring = true;
+    return pointer_value;
+  } else {
+    return 0;
   }
-  return 0;
 }
 
 // get_pointer_64 returns a pointer to the bytes in the object file at the
@@ -2362,27 +2491,15 @@ static const char *get_pointer_64(uint64_t Address, uint32_t &offset,
   offset = 0;
   left = 0;
   S = SectionRef();
-  for (unsigned SectIdx = 0; SectIdx != info->Sections->size(); SectIdx++) {
-    uint64_t SectAddress = ((*(info->Sections))[SectIdx]).getAddress();
-    uint64_t SectSize = ((*(info->Sections))[SectIdx]).getSize();
-    if (objc_only) {
-      StringRef SectName;
-      ((*(info->Sections))[SectIdx]).getName(SectName);
-      DataRefImpl Ref = ((*(info->Sections))[SectIdx]).getRawDataRefImpl();
-      StringRef SegName = info->O->getSectionFinalSegmentName(Ref);
-      if (SegName != "__OBJC" && SectName != "__cstring")
-        continue;
-    }
-    if (Address >= SectAddress && Address < SectAddress + SectSize) {
-      S = (*(info->Sections))[SectIdx];
-      offset = Address - SectAddress;
-      left = SectSize - offset;
-      StringRef SectContents;
-      ((*(info->Sections))[SectIdx]).getContents(SectContents);
-      return SectContents.data() + offset;
-    }
-  }
-  return nullptr;
+  const SectionRef *Sec = info->Index->findSection(Address, objc_only);
+  if (!Sec)
+    return nullptr;
+  S = *Sec;
+  offset = Address - S.getAddress();
+  left = S.getSize() - offset;
+  StringRef SectContents;
+  S.getContents(SectContents);
+  return SectContents.data() + offset;
 }
 
 static const char *get_pointer_32(uint32_t Address, uint32_t &offset,
@@ -2406,25 +2523,18 @@ static const char *get_symbol_64(uint32_t sect_offset, SectionRef S,
 
   // See if there is an external relocation entry at the sect_offset.
   bool reloc_found = false;
-  DataRefImpl Rel;
-  MachO::any_relocation_info RE;
   bool isExtern = false;
   SymbolRef Symbol;
-  for (const RelocationRef &Reloc : S.relocations()) {
-    uint64_t RelocOffset = Reloc.getOffset();
-    if (RelocOffset == sect_offset) {
-      Rel = Reloc.getRawDataRefImpl();
-      RE = info->O->getRelocation(Rel);
-      if (info->O->isRelocationScattered(RE))
-        continue;
-      isExtern = info->O->getPlainRelocationExternal(RE);
-      if (isExtern) {
-        symbol_iterator RelocSym = Reloc.getSymbol();
-        Symbol = *RelocSym;
-      }
-      reloc_found = true;
-      break;
+  RelocationRef Reloc;
+  if (info->Index->findPlainRelocation(S, sect_offset, Reloc)) {
+    MachO::any_relocation_info RE =
+        info->O->getRelocation(Reloc.getRawDataRefImpl());
+    isExtern = info->O->getPlainRelocationExternal(RE);
+    if (isExtern) {
+      symbol_iterator RelocSym = Reloc.getSymbol();
+      Symbol = *RelocSym;
     }
+    reloc_found = true;
   }
   // If there is an external relocation entry for a symbol in this section
   // at this section_offset then use that symbol's value for the n_value
@@ -5129,6 +5239,8 @@ static void printObjc2_64bit_MetaData(MachOObjectFile *O, bool verbose) {
   info.O = O;
   info.AddrMap = &AddrMap;
   info.Sections = &Sections;
+  MachOAddressIndex Index(O, Sections);
+  info.Index = &Index;
   info.class_name = nullptr;
   info.selector_name = nullptr;
   info.method = nullptr;
@@ -5229,6 +5341,8 @@ static void printObjc2_32bit_MetaData(MachOObjectFile *O, bool verbose) {
   info.O = O;
   info.AddrMap = &AddrMap;
   info.Sections = &Sections;
+  MachOAddressIndex Index(O, Sections);
+  info.Index = &Index;
   info.class_name = nullptr;
   info.selector_name = nullptr;
   info.method = nullptr;
@@ -5339,6 +5453,8 @@ static bool printObjc1_32bit_MetaData(MachOObjectFile *O, bool verbose) {
   info.O = O;
   info.AddrMap = &AddrMap;
   info.Sections = &Sections;
+  MachOAddressIndex Index(O, Sections);
+  info.Index = &Index;
   info.class_name = nullptr;
   info.selector_name = nullptr;
   info.method = nullptr;
@@ -5512,6 +5628,8 @@ static void DumpProtocolSection(MachOObjectFile *O, const char *sect,
   info.O = O;
   info.AddrMap = &AddrMap;
   info.Sections = &Sections;
+  MachOAddressIndex Index(O, Sections);
+  info.Index = &Index;
   info.class_name = nullptr;
   info.selector_name = nullptr;
   info.method = nullptr;
@@ -6011,6 +6129,10 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
   getSectionsAndSymbols(MachOOF, Sections, Symbols, FoundFns,
                         BaseSegmentAddress);
 
+  // The address lookups of the symbolizer call backs are shared by all the
+  // sections.
+  MachOAddressIndex AddrIndex(MachOOF, Sections);
+
   // Sort the symbols by address, just in case they didn't come in that way.
   std::sort(Symbols.begin(), Symbols.end(), SymbolSorter());
 
@@ -6061,6 +6183,15 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
   if (FilterSections.size() == 0)
     outs() << "(" << DisSegName << "," << DisSectName << ") section\n";
 
+  // Instructions are decoded in batches ahead of printing them. The MCInsts
+  // are reused across batches, so their operand storage is only allocated
+  // once.
+  const unsigned BatchSize = 64;
+  MCInst Batch[BatchSize];
+  SmallVector<uint64_t, BatchSize> BatchSizes;
+  SmallVector<uint64_t, BatchSize> BatchCommentEnds;
+  SmallString<1024> BatchComments;
+
   for (unsigned SectIdx = 0; SectIdx != Sections.size(); SectIdx++) {
     StringRef SectName;
     if (Sections[SectIdx].getName(SectName) || SectName != DisSectName)
@@ -6121,6 +6252,7 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
     SymbolizerInfo.S = Sections[SectIdx];
     SymbolizerInfo.AddrMap = &AddrMap;
     SymbolizerInfo.Sections = &Sections;
+    SymbolizerInfo.Index = &AddrIndex;
     SymbolizerInfo.class_name = nullptr;
     SymbolizerInfo.selector_name = nullptr;
     SymbolizerInfo.method = nullptr;
@@ -6134,6 +6266,7 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
     ThumbSymbolizerInfo.S = Sections[SectIdx];
     ThumbSymbolizerInfo.AddrMap = &AddrMap;
     ThumbSymbolizerInfo.Sections = &Sections;
+    ThumbSymbolizerInfo.Index = &AddrIndex;
     ThumbSymbolizerInfo.class_name = nullptr;
     ThumbSymbolizerInfo.selector_name = nullptr;
     ThumbSymbolizerInfo.method = nullptr;
@@ -6196,9 +6329,10 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
 
       outs() << SymName << ":\n";
       DILineInfo lastLine;
+      MCDisassembler *SymDisAsm = isThumb ? ThumbDisAsm.get() : DisAsm.get();
+      size_t BatchIdx = 0, BatchEnd = 0;
+      uint64_t CommentBegin = 0;
       for (uint64_t Index = Start; Index < End; Index += Size) {
-        MCInst Inst;
-
         uint64_t PC = SectAddress + Index;
         if (!NoLeadingAddr) {
           if (FullLeadingAddr) {
@@ -6232,26 +6366,53 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
           continue;
         }
 
-        SmallVector<char, 64> AnnotationsBytes;
-        raw_svector_ostream Annotations(AnnotationsBytes);
+        if (BatchIdx == BatchEnd) {
+          // Decode the next batch, stopping before the next data in code
+          // entry, which is not decoded at all.
+          uint64_t BatchLimit = End;
+          for (const auto &D : Dices)
+            if (D.first > PC && D.first - SectAddress < BatchLimit)
+              BatchLimit = D.first - SectAddress;
+          BatchComments.clear();
+          raw_svector_ostream Comments(BatchComments);
+          BatchIdx = 0;
+          BatchEnd = SymDisAsm->getInstructions(
+              Bytes.slice(Index, BatchLimit - Index), PC, Batch, BatchSizes,
+              DebugOut, Comments, &BatchCommentEnds);
+          CommentBegin = 0;
+        }
 
+        MCInst SingleInst;
+        MCInst *Inst = &SingleInst;
+        SmallVector<char, 64> AnnotationsBytes;
+        StringRef AnnotationsStr;
         bool gotInst;
-        if (isThumb)
-          gotInst = ThumbDisAsm->getInstruction(Inst, Size, Bytes.slice(Index),
-                                                PC, DebugOut, Annotations);
-        else
-          gotInst = DisAsm->getInstruction(Inst, Size, Bytes.slice(Index), PC,
-                                           DebugOut, Annotations);
+        if (BatchIdx != BatchEnd) {
+          gotInst = true;
+          Inst = &Batch[BatchIdx];
+          Size = BatchSizes[BatchIdx];
+          AnnotationsStr = StringRef(BatchComments).slice(
+              CommentBegin, BatchCommentEnds[BatchIdx]);
+          CommentBegin = BatchCommentEnds[BatchIdx];
+          ++BatchIdx;
+        } else {
+          // The batch stopped at an instruction that failed to decode. Decode
+          // it again on its own to know how many bytes the decoder consumed.
+          raw_svector_ostream Annotations(AnnotationsBytes);
+          gotInst = SymDisAsm->getInstruction(SingleInst, Size,
+                                              Bytes.slice(Index), PC, DebugOut,
+                                              Annotations);
+          AnnotationsStr = Annotations.str();
+        }
         if (gotInst) {
           if (!NoShowRawInsn) {
             dumpBytes(ArrayRef<uint8_t>(Bytes.data() + Index, Size), outs());
           }
           formatted_raw_ostream FormattedOS(outs());
-          StringRef AnnotationsStr = Annotations.str();
           if (isThumb)
-            ThumbIP->printInst(&Inst, FormattedOS, AnnotationsStr, *ThumbSTI);
+            ThumbIP->printInst(Inst, FormattedOS, AnnotationsStr, *ThumbSTI);
           else
-            IP->printInst(&Inst, FormattedOS, AnnotationsStr, *STI);
+            IP->printInst(Inst, FormattedOS, AnnotationsStr, *STI);
           emitComments(CommentStream, CommentsToEmit, FormattedOS, *AsmInfo);
 
           // Print debug info.
@@ -6290,12 +6451,31 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
       uint64_t SectAddress = Sections[SectIdx].getAddress();
       uint64_t SectSize = Sections[SectIdx].getSize();
       uint64_t InstSize;
+      size_t BatchIdx = 0, BatchEnd = 0;
       for (uint64_t Index = 0; Index < SectSize; Index += InstSize) {
-        MCInst Inst;
-
         uint64_t PC = SectAddress + Index;
-        if (DisAsm->getInstruction(Inst, InstSize, Bytes.slice(Index), PC,
-                                   DebugOut, nulls())) {
+        if (BatchIdx == BatchEnd) {
+          BatchIdx = 0;
+          BatchEnd = DisAsm->getInstructions(Bytes.slice(Index), PC, Batch,
+                                             BatchSizes, DebugOut, nulls(),
+                                             nullptr);
+        }
+
+        MCInst SingleInst;
+        MCInst *Inst = &SingleInst;
+        bool gotInst;
+        if (BatchIdx != BatchEnd) {
+          gotInst = true;
+          Inst = &Batch[BatchIdx];
+          InstSize = BatchSizes[BatchIdx++];
+        } else {
+          // The batch stopped at an instruction that failed to decode. Decode
+          // it again on its own to know how many bytes the decoder consumed.
+          gotInst = DisAsm->getInstruction(SingleInst, InstSize,
+                                           Bytes.slice(Index), PC, DebugOut,
+                                           nulls());
+        }
+        if (gotInst) {
           if (!NoLeadingAddr) {
             if (FullLeadingAddr) {
               if (MachOOF->is64Bit())
@@ -6310,7 +6490,7 @@ static void DisassembleMachO(StringRef Filename, MachOObjectFile *MachOOF,
             outs() << "\t";
             dumpBytes(ArrayRef<uint8_t>(Bytes.data() + Index, InstSize), outs());
           }
-          IP->printInst(&Inst, outs(), "", *STI);
+          IP->printInst(Inst, outs(), "", *STI);
           outs() << "\n";
         } else {
           unsigned int Arch = MachOOF->getArch();
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ProfileData/InstrProfWriter.h"
@@ -26,6 +27,8 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/thread.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -41,8 +44,52 @@ namespace {
 enum ProfileKinds { instr, sample };
 }
 
+namespace {
+/// A subset of the inputs of an instrumentation profile merge, and the
+/// diagnostics of reading it.
+struct WriterContext {
+  InstrProfWriter Writer;
+  std::string Warnings;
+  /// The first error, after which no more input is read.
+  std::error_code Err;
+  std::string ErrWhence;
+};
+}
+
+/// Add the counts of \p Filename to \p WC, unless it already failed.
+static void loadInput(StringRef Filename, WriterContext &WC) {
+  if (WC.Err)
+    return;
+
+  auto ReaderOrErr = InstrProfReader::create(Filename);
+  if (std::error_code EC = ReaderOrErr.getError()) {
+    WC.Err = EC;
+    WC.ErrWhence = Filename;
+    return;
+  }
+
+  raw_string_ostream Warnings(WC.Warnings);
+  auto Reader = std::move(ReaderOrErr.get());
+  for (const auto &I : *Reader)
+    if (std::error_code EC =
+            WC.Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
+      Warnings << Filename << ": " << I.Name << ": " << EC.message() << "\n";
+  if (Reader->hasError()) {
+    WC.Err = Reader->getError();
+    WC.ErrWhence = Filename;
+  }
+}
+
+/// Print the diagnostics of \p WC, and exit if it failed.
+static void reportDiagnostics(WriterContext &WC) {
+  errs() << WC.Warnings;
+  WC.Warnings.clear();
+  if (WC.Err)
+    exitWithError(WC.Err.message(), WC.ErrWhence);
+}
+
 static void mergeInstrProfile(const cl::list<std::string> &Inputs,
-                              StringRef OutputFilename) {
+                              StringRef OutputFilename, unsigned NumThreads) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -51,21 +98,56 @@ static void mergeInstrProfile(const cl::list<std::string> &Inputs,
   if (EC)
     exitWithError(EC.message(), OutputFilename);
 
-  InstrProfWriter Writer;
-  for (const auto &Filename : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Filename);
-    if (std::error_code ec = ReaderOrErr.getError())
-      exitWithError(ec.message(), Filename);
-
-    auto Reader = std::move(ReaderOrErr.get());
-    for (const auto &I : *Reader)
-      if (std::error_code EC =
-              Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
-        errs() << Filename << ": " << I.Name << ": " << EC.message() << "\n";
-    if (Reader->hasError())
-      exitWithError(Reader->getError().message(), Filename);
+#if !LLVM_ENABLE_THREADS
+  NumThreads = 1;
+#endif
+  NumThreads = std::max(1U, std::min<unsigned>(NumThreads, Inputs.size()));
+
+  // Each thread reads a contiguous range of the inputs into its own writer.
+  // The writers are then reduced pairwise, always merging a range into the
+  // one that precedes it, so that the counts are summed and checked in
+  // input order, like in a serial merge.
+  std::vector<WriterContext> Contexts(NumThreads);
+  if (NumThreads == 1) {
+    for (const auto &Filename : Inputs) {
+      loadInput(Filename, Contexts[0]);
+      reportDiagnostics(Contexts[0]);
+    }
+  } else {
+#if LLVM_ENABLE_THREADS
+    std::vector<std::thread> Threads;
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Threads.emplace_back([&, T] {
+        size_t Begin = Inputs.size() * T / NumThreads;
+        size_t End = Inputs.size() * (T + 1) / NumThreads;
+        for (size_t I = Begin; I != End; ++I)
+          loadInput(Inputs[I], Contexts[T]);
+      });
+    for (auto &Thread : Threads)
+      Thread.join();
+    for (auto &WC : Contexts)
+      reportDiagnostics(WC);
+
+    for (unsigned Step = 1; Step < NumThreads; Step *= 2) {
+      Threads.clear();
+      for (unsigned T = 0; T + Step < NumThreads; T += 2 * Step)
+        Threads.emplace_back([&, T] {
+          WriterContext &Dst = Contexts[T];
+          raw_string_ostream Warnings(Dst.Warnings);
+          Dst.Writer.mergeRecordsFromWriter(
+              std::move(Contexts[T + Step].Writer),
+              [&](StringRef Name, std::error_code EC) {
+                Warnings << Name << ": " << EC.message() << "\n";
+              });
+        });
+      for (auto &Thread : Threads)
+        Thread.join();
+      for (unsigned T = 0; T + Step < NumThreads; T += 2 * Step)
+        reportDiagnostics(Contexts[T]);
+    }
+#endif
   }
-  Writer.write(Output);
+  Contexts[0].Writer.write(Output);
 }
 
 static void mergeSampleProfile(const cl::list<std::string> &Inputs,
@@ -123,10 +205,17 @@ static int merge_main(int argc, const char *argv[]) {
                  clEnumValN(sampleprof::SPF_GCC, "gcc", "GCC encoding"),
                  clEnumValEnd));
 
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(1),
+      cl::desc("Number of threads to read and merge the instrumentation "
+               "profiles with"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
+
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
   if (ProfileKind == instr)
-    mergeInstrProfile(Inputs, OutputFilename);
+    mergeInstrProfile(Inputs, OutputFilename, NumThreads);
   else
     mergeSampleProfile(Inputs, OutputFilename, OutputFormat);
 
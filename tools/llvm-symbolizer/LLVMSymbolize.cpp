@@ -83,6 +83,22 @@ ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
       computeSymbolSizes(*Module);
   for (auto &P : Symbols)
     addSymbol(P.first, P.second, OpdExtractor.get(), OpdAddress);
+  sortSymbols(Functions);
+  sortSymbols(Objects);
+}
+
+void ModuleInfo::sortSymbols(SymbolVector &Symbols) {
+  std::stable_sort(Symbols.begin(), Symbols.end(),
+                   [](const SymbolVector::value_type &LHS,
+                      const SymbolVector::value_type &RHS) {
+    return LHS.first < RHS.first;
+  });
+  Symbols.erase(std::unique(Symbols.begin(), Symbols.end(),
+                            [](const SymbolVector::value_type &LHS,
+                               const SymbolVector::value_type &RHS) {
+                  return LHS.first.Addr == RHS.first.Addr;
+                }),
+                Symbols.end());
 }
 
 void ModuleInfo::addSymbol(const SymbolRef &Symbol, uint64_t SymbolSize,
@@ -117,7 +133,7 @@ void ModuleInfo::addSymbol(const SymbolRef &Symbol, uint64_t SymbolSize,
   // with same address size. Make sure we choose the correct one.
   auto &M = SymbolType == SymbolRef::ST_Function ? Functions : Objects;
   SymbolDesc SD = { SymbolAddress, SymbolSize };
-  M.insert(std::make_pair(SD, SymbolName));
+  M.push_back(std::make_pair(SD, SymbolName));
 }
 
 // Return true if this is a 32-bit x86 PE COFF module.
@@ -133,7 +149,12 @@ bool ModuleInfo::getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
   if (SymbolMap.empty())
     return false;
   SymbolDesc SD = { Address, Address };
-  auto SymbolIterator = SymbolMap.upper_bound(SD);
+  auto SymbolIterator =
+      std::upper_bound(SymbolMap.begin(), SymbolMap.end(), SD,
+                       [](const SymbolDesc &LHS,
+                          const SymbolVector::value_type &RHS) {
+    return LHS < RHS.first;
+  });
   if (SymbolIterator == SymbolMap.begin())
     return false;
   --SymbolIterator;
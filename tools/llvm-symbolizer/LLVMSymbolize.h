@@ -22,6 +22,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -138,8 +139,12 @@ private:
       return s1.Addr < s2.Addr;
     }
   };
-  std::map<SymbolDesc, StringRef> Functions;
-  std::map<SymbolDesc, StringRef> Objects;
+  // Sorted by address once all the symbols are added; of the symbols sharing
+  // an address, only the first one added is kept.
+  typedef std::vector<std::pair<SymbolDesc, StringRef>> SymbolVector;
+  SymbolVector Functions;
+  SymbolVector Objects;
+  static void sortSymbols(SymbolVector &Symbols);
 };
 
 } // namespace symbolize
@@ -26,9 +26,12 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <tuple>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -74,6 +77,11 @@ ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
                     "object files"));
 
+static cl::opt<bool>
+ClBatch("batch", cl::init(false),
+        cl::desc("Read all the input before symbolizing it, and look the "
+                 "addresses up in increasing order per module"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -148,6 +156,39 @@ int main(int argc, char **argv) {
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
+
+  if (ClBatch) {
+    // Visiting the addresses of a module in order keeps the lookups within
+    // the same compile unit and line table for as long as possible.
+    struct Command {
+      std::string ModuleName;
+      bool IsData;
+      uint64_t ModuleOffset;
+      std::string Result;
+    };
+    std::vector<Command> Commands;
+    while (parseCommand(IsData, ModuleName, ModuleOffset))
+      Commands.push_back({ModuleName, IsData, ModuleOffset, ""});
+
+    std::vector<Command *> Sorted;
+    for (Command &C : Commands)
+      Sorted.push_back(&C);
+    std::stable_sort(Sorted.begin(), Sorted.end(),
+                     [](const Command *LHS, const Command *RHS) {
+      return std::tie(LHS->ModuleName, LHS->IsData, LHS->ModuleOffset) <
+             std::tie(RHS->ModuleName, RHS->IsData, RHS->ModuleOffset);
+    });
+    for (Command *C : Sorted)
+      C->Result =
+          C->IsData ? Symbolizer.symbolizeData(C->ModuleName, C->ModuleOffset)
+                    : Symbolizer.symbolizeCode(C->ModuleName, C->ModuleOffset);
+
+    for (const Command &C : Commands)
+      outs() << C.Result << "\n";
+    outs().flush();
+    return 0;
+  }
+
   while (parseCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
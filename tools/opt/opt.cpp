@@ -23,6 +23,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
@@ -180,6 +181,13 @@ DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
           cl::value_desc("layout-string"), cl::init(""));
 
+static cl::list<std::string> MaterializeOnly(
+    "materialize-only", cl::CommaSeparated,
+    cl::desc("Only read the bodies of these functions from the input "
+             "bitcode; 0x<addr> selects the function translated from that "
+             "address"),
+    cl::value_desc("function|0xaddr,..."));
+
 static cl::opt<bool> PreserveBitcodeUseListOrder(
     "preserve-bc-uselistorder",
     cl::desc("Preserve use-list order when writing LLVM bitcode."),
@@ -340,13 +348,31 @@ int main(int argc, char **argv) {
   SMDiagnostic Err;
 
   // Load the input module...
-  std::unique_ptr<Module> M = parseIRFile(InputFilename, Err, Context);
+  std::unique_ptr<Module> M;
+  if (MaterializeOnly.empty())
+    M = parseIRFile(InputFilename, Err, Context);
+  else
+    M = getLazyIRFileModule(InputFilename, Err, Context);
 
   if (!M) {
     Err.print(argv[0], errs());
     return 1;
   }
 
+  if (!MaterializeOnly.empty()) {
+    std::vector<std::string> Missing;
+    std::error_code EC = materializeFunctionsOnly(*M, MaterializeOnly, Missing);
+    if (!EC)
+      EC = M->materializeAllPermanently();
+    if (EC) {
+      errs() << argv[0] << ": " << InputFilename << ": error: "
+             << EC.message() << '\n';
+      return 1;
+    }
+    for (const std::string &Name : Missing)
+      errs() << argv[0] << ": warning: no function '" << Name << "'\n";
+  }
+
   // Strip debug info before running the verifier.
   if (StripDebug)
     StripDebugInfo(*M);
@@ -0,0 +1,195 @@
+//===- unittests/Object/MachOObjectFileTest.cpp ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/MachO.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MachO.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+const uint64_t TextAddr = 0x100000000ULL;
+const uint64_t DataAddr = 0x200000000ULL;
+const uint64_t SectSize = 0x10;
+const unsigned NumTextSections = 4000;
+const unsigned NumDataSections = 100;
+
+struct SyntheticSegment {
+  const char *Name;
+  uint64_t VMAddr;
+  uint64_t VMSize;
+  uint64_t FileOff;
+  uint64_t FileSize;
+  std::vector<MachO::section_64> Sections;
+};
+
+MachO::section_64 makeSection(const std::string &SectName,
+                              const char *SegName, uint64_t Addr,
+                              uint32_t Type) {
+  MachO::section_64 S;
+  memset(&S, 0, sizeof(S));
+  strncpy(S.sectname, SectName.c_str(), sizeof(S.sectname));
+  strncpy(S.segname, SegName, sizeof(S.segname));
+  S.addr = Addr;
+  S.size = SectSize;
+  S.flags = Type;
+  return S;
+}
+
+// A 64-bit executable with a __PAGEZERO, and many sections in __TEXT and
+// __DATA. Every tenth __TEXT section is a cstring section, and every
+// __DATA section is a mod_init_func section. Both segments have a "__dup"
+// section.
+class MachOLookupTest : public ::testing::Test {
+protected:
+  std::vector<char> Buffer;
+  std::unique_ptr<MachOObjectFile> Obj;
+
+  void SetUp() override {
+    SyntheticSegment Segments[3] = {
+        {"__PAGEZERO", 0, TextAddr, 0, 0, {}},
+        {"__TEXT", TextAddr, (NumTextSections + 1) * SectSize, 0, 0x1000, {}},
+        {"__DATA", DataAddr, (NumDataSections + 1) * SectSize, 0x1000, 0x1000,
+         {}}};
+    for (unsigned i = 0; i != NumTextSections; ++i)
+      Segments[1].Sections.push_back(makeSection(
+          "__t" + std::to_string(i), "__TEXT", TextAddr + i * SectSize,
+          i % 10 ? MachO::S_REGULAR : MachO::S_CSTRING_LITERALS));
+    Segments[1].Sections.push_back(makeSection(
+        "__dup", "__TEXT", TextAddr + NumTextSections * SectSize,
+        MachO::S_REGULAR));
+    for (unsigned i = 0; i != NumDataSections; ++i)
+      Segments[2].Sections.push_back(makeSection(
+          "__d" + std::to_string(i), "__DATA", DataAddr + i * SectSize,
+          MachO::S_MOD_INIT_FUNC_POINTERS));
+    Segments[2].Sections.push_back(makeSection(
+        "__dup", "__DATA", DataAddr + NumDataSections * SectSize,
+        MachO::S_REGULAR));
+
+    MachO::mach_header_64 Header;
+    memset(&Header, 0, sizeof(Header));
+    Header.magic = MachO::MH_MAGIC_64;
+    Header.cputype = MachO::CPU_TYPE_ARM64;
+    Header.filetype = MachO::MH_EXECUTE;
+    Header.ncmds = array_lengthof(Segments);
+    for (const SyntheticSegment &Seg : Segments)
+      Header.sizeofcmds += sizeof(MachO::segment_command_64) +
+                           Seg.Sections.size() * sizeof(MachO::section_64);
+    append(Header);
+
+    for (const SyntheticSegment &Seg : Segments) {
+      MachO::segment_command_64 Cmd;
+      memset(&Cmd, 0, sizeof(Cmd));
+      Cmd.cmd = MachO::LC_SEGMENT_64;
+      Cmd.cmdsize = sizeof(MachO::segment_command_64) +
+                    Seg.Sections.size() * sizeof(MachO::section_64);
+      strncpy(Cmd.segname, Seg.Name, sizeof(Cmd.segname));
+      Cmd.vmaddr = Seg.VMAddr;
+      Cmd.vmsize = Seg.VMSize;
+      Cmd.fileoff = Seg.FileOff;
+      Cmd.filesize = Seg.FileSize;
+      Cmd.nsects = Seg.Sections.size();
+      append(Cmd);
+      for (const MachO::section_64 &S : Seg.Sections)
+        append(S);
+    }
+
+    auto ObjOrErr = ObjectFile::createMachOObjectFile(
+        MemoryBufferRef(StringRef(Buffer.data(), Buffer.size()), "synthetic"));
+    ASSERT_FALSE(ObjOrErr.getError());
+    Obj = std::move(*ObjOrErr);
+  }
+
+  template <typename T> void append(const T &Struct) {
+    const char *P = reinterpret_cast<const char *>(&Struct);
+    Buffer.insert(Buffer.end(), P, P + sizeof(T));
+  }
+
+  uint64_t addressOf(StringRef SegName, StringRef SectName) {
+    section_iterator I = Obj->findSection(SegName, SectName);
+    if (I == Obj->section_end())
+      return 0;
+    return I->getAddress();
+  }
+};
+
+TEST_F(MachOLookupTest, FindSection) {
+  // Check every section against a walk over the section list.
+  for (const SectionRef &Section : Obj->sections()) {
+    StringRef Name;
+    ASSERT_FALSE(Section.getName(Name));
+    if (Name == "__dup")
+      continue;
+    StringRef SegName =
+        Obj->getSectionFinalSegmentName(Section.getRawDataRefImpl());
+    EXPECT_EQ(Section.getAddress(), addressOf(SegName, Name));
+    EXPECT_EQ(Section.getAddress(), addressOf("", Name));
+  }
+
+  EXPECT_EQ(TextAddr + NumTextSections * SectSize, addressOf("", "__dup"));
+  EXPECT_EQ(TextAddr + NumTextSections * SectSize,
+            addressOf("__TEXT", "__dup"));
+  EXPECT_EQ(DataAddr + NumDataSections * SectSize,
+            addressOf("__DATA", "__dup"));
+  EXPECT_EQ(Obj->section_end(), Obj->findSection("__DATA", "__t1"));
+  EXPECT_EQ(Obj->section_end(), Obj->findSection("", "__none"));
+  EXPECT_EQ(Obj->section_end(), Obj->findSection("__LINKEDIT", "__dup"));
+}
+
+TEST_F(MachOLookupTest, SectionsOfType) {
+  ArrayRef<SectionRef> Cstrings =
+      Obj->sectionsOfType(MachO::S_CSTRING_LITERALS);
+  ASSERT_EQ(NumTextSections / 10, Cstrings.size());
+  for (unsigned i = 0, e = Cstrings.size(); i != e; ++i)
+    EXPECT_EQ(TextAddr + i * 10 * SectSize, Cstrings[i].getAddress());
+
+  ArrayRef<SectionRef> ModInit =
+      Obj->sectionsOfType(MachO::S_MOD_INIT_FUNC_POINTERS);
+  ASSERT_EQ(NumDataSections, ModInit.size());
+  EXPECT_EQ(DataAddr, ModInit.front().getAddress());
+
+  EXPECT_TRUE(Obj->sectionsOfType(MachO::S_SYMBOL_STUBS).empty());
+}
+
+TEST_F(MachOLookupTest, Segments) {
+  ArrayRef<MachOObjectFile::SegmentInfo> Segments = Obj->segments();
+  ASSERT_EQ(3u, Segments.size());
+  EXPECT_EQ("__PAGEZERO", Segments[0].Name);
+  EXPECT_EQ("__TEXT", Segments[1].Name);
+  EXPECT_EQ(2u, Segments[2].Index);
+
+  const MachOObjectFile::SegmentInfo *Seg = Obj->findSegmentContaining(0x10);
+  ASSERT_TRUE(Seg);
+  EXPECT_EQ("__PAGEZERO", Seg->Name);
+  Seg = Obj->findSegmentContaining(TextAddr + 0x100);
+  ASSERT_TRUE(Seg);
+  EXPECT_EQ("__TEXT", Seg->Name);
+  Seg = Obj->findSegmentContaining(DataAddr);
+  ASSERT_TRUE(Seg);
+  EXPECT_EQ("__DATA", Seg->Name);
+  EXPECT_FALSE(Obj->findSegmentContaining(DataAddr - 1));
+  EXPECT_FALSE(Obj->findSegmentContaining(DataAddr + 0x100000));
+
+  // __PAGEZERO has no file contents.
+  Seg = Obj->findSegmentForFileOffset(0);
+  ASSERT_TRUE(Seg);
+  EXPECT_EQ("__TEXT", Seg->Name);
+  Seg = Obj->findSegmentForFileOffset(0x1fff);
+  ASSERT_TRUE(Seg);
+  EXPECT_EQ("__DATA", Seg->Name);
+  EXPECT_FALSE(Obj->findSegmentForFileOffset(0x2000));
+}
+
+} // end anonymous namespace
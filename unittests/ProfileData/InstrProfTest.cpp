@@ -101,4 +101,33 @@ TEST_F(InstrProfTest, get_max_function_count) {
   ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
 }
 
+TEST_F(InstrProfTest, merge_writers) {
+  // The first counts added for a function and hash win, in the order of the
+  // merged writers.
+  Writer.addFunctionCounts("foo", 0x1234, {1, 2});
+  InstrProfWriter Writer2;
+  Writer2.addFunctionCounts("foo", 0x1234, {3, 4, 5});
+  Writer2.addFunctionCounts("foo", 0x1234, {6, 7});
+  Writer2.addFunctionCounts("bar", 0, {1ULL << 40});
+  unsigned NumWarnings = 0;
+  Writer.mergeRecordsFromWriter(std::move(Writer2),
+                                [&](StringRef Name, std::error_code EC) {
+    ASSERT_EQ(StringRef("foo"), Name);
+    ASSERT_TRUE(ErrorEquals(instrprof_error::count_mismatch, EC));
+    ++NumWarnings;
+  });
+  ASSERT_EQ(1U, NumWarnings);
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  std::vector<uint64_t> Counts;
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("foo", 0x1234, Counts)));
+  ASSERT_EQ(2U, Counts.size());
+  ASSERT_EQ(7U, Counts[0]);
+  ASSERT_EQ(9U, Counts[1]);
+  ASSERT_TRUE(NoError(Reader->getFunctionCounts("bar", 0, Counts)));
+  ASSERT_EQ(1ULL << 40, Counts[0]);
+  ASSERT_EQ(1ULL << 40, Reader->getMaximumFunctionCount());
+}
+
 } // end anonymous namespace
@@ -0,0 +1,290 @@
+//===- llvm/unittest/Target/AArch64/DisassemblerTest.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Check that the direct-dispatch decoder agrees with the decoder table
+// interpreter it is generated from, and that the batch decoding entry points
+// agree with decoding one instruction at a time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Disassembler/AArch64Disassembler.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+
+using namespace llvm;
+
+namespace {
+
+class AArch64DisassemblerTest : public testing::Test {
+protected:
+  void SetUp() override {
+    LLVMInitializeAArch64TargetInfo();
+    LLVMInitializeAArch64TargetMC();
+    LLVMInitializeAArch64Disassembler();
+
+    std::string TT = "arm64-apple-ios";
+    std::string Error;
+    const Target *T = TargetRegistry::lookupTarget(TT, Error);
+    ASSERT_TRUE(T) << Error;
+
+    MRI.reset(T->createMCRegInfo(TT));
+    MAI.reset(T->createMCAsmInfo(*MRI, TT));
+    MII.reset(T->createMCInstrInfo());
+    STI.reset(T->createMCSubtargetInfo(TT, "", ""));
+    Ctx.reset(new MCContext(MAI.get(), MRI.get(), nullptr));
+    DisAsm.reset(static_cast<AArch64Disassembler *>(
+        T->createMCDisassembler(*STI, *Ctx)));
+    ASSERT_TRUE(DisAsm != nullptr);
+  }
+
+  // Decode Insn with both decoders, and check that they agree on the status,
+  // the opcode, and every operand.
+  void checkSameDecoding(uint32_t Insn) {
+    uint8_t Bytes[] = {uint8_t(Insn), uint8_t(Insn >> 8), uint8_t(Insn >> 16),
+                       uint8_t(Insn >> 24)};
+    uint64_t DirectSize, TableSize;
+    MCInst DirectMI, TableMI;
+    MCDisassembler::DecodeStatus DirectS =
+        DisAsm->getInstruction(DirectMI, DirectSize, Bytes, 0, nulls(),
+                               nulls());
+    MCDisassembler::DecodeStatus TableS =
+        DisAsm->getInstructionFromTable(TableMI, TableSize, Bytes, 0, nulls(),
+                                        nulls());
+
+    SCOPED_TRACE("insn 0x" + utohexstr(Insn));
+    ASSERT_EQ(TableS, DirectS);
+    ASSERT_EQ(TableSize, DirectSize);
+    if (TableS == MCDisassembler::Fail)
+      return;
+    ASSERT_EQ(MII->getName(TableMI.getOpcode()),
+              MII->getName(DirectMI.getOpcode()));
+    ASSERT_EQ(TableMI.getNumOperands(), DirectMI.getNumOperands());
+    for (unsigned i = 0, e = TableMI.getNumOperands(); i != e; ++i) {
+      const MCOperand &TableOp = TableMI.getOperand(i);
+      const MCOperand &DirectOp = DirectMI.getOperand(i);
+      ASSERT_EQ(TableOp.isReg(), DirectOp.isReg());
+      ASSERT_EQ(TableOp.isImm(), DirectOp.isImm());
+      ASSERT_EQ(TableOp.isFPImm(), DirectOp.isFPImm());
+      if (TableOp.isReg()) {
+        EXPECT_EQ(TableOp.getReg(), DirectOp.getReg());
+      } else if (TableOp.isImm()) {
+        EXPECT_EQ(TableOp.getImm(), DirectOp.getImm());
+      } else if (TableOp.isFPImm()) {
+        EXPECT_EQ(TableOp.getFPImm(), DirectOp.getFPImm());
+      }
+    }
+  }
+
+  // Check that decoding Bytes in batches of BatchSize, with either the
+  // AArch64 or the default implementation of getInstructions, gives the same
+  // instructions as getInstruction, and stops at the first failure.
+  void checkBatchDecoding(ArrayRef<uint8_t> Bytes, size_t BatchSize,
+                          bool UseDefault) {
+    std::vector<MCInst> Batch(BatchSize);
+    SmallVector<uint64_t, 16> Sizes;
+    size_t NumDecoded =
+        UseDefault
+            ? DisAsm->MCDisassembler::getInstructions(Bytes, 0x1000, Batch,
+                                                      Sizes, nulls(), nulls(),
+                                                      nullptr)
+            : DisAsm->getInstructions(Bytes, 0x1000, Batch, Sizes);
+    ASSERT_EQ(NumDecoded, Sizes.size());
+
+    size_t Expected = 0;
+    for (uint64_t Off = 0; Expected != BatchSize && Off + 4 <= Bytes.size();
+         Off += 4, ++Expected) {
+      MCInst MI;
+      uint64_t Size;
+      if (DisAsm->getInstruction(MI, Size, Bytes.slice(Off), 0x1000 + Off,
+                                 nulls(), nulls()) == MCDisassembler::Fail)
+        break;
+      ASSERT_LT(Expected, NumDecoded);
+      EXPECT_EQ(Size, Sizes[Expected]);
+      const MCInst &BatchMI = Batch[Expected];
+      ASSERT_EQ(MI.getOpcode(), BatchMI.getOpcode());
+      ASSERT_EQ(MI.getNumOperands(), BatchMI.getNumOperands());
+      for (unsigned i = 0, e = MI.getNumOperands(); i != e; ++i) {
+        if (MI.getOperand(i).isReg()) {
+          EXPECT_EQ(MI.getOperand(i).getReg(), BatchMI.getOperand(i).getReg());
+        } else if (MI.getOperand(i).isImm()) {
+          EXPECT_EQ(MI.getOperand(i).getImm(), BatchMI.getOperand(i).getImm());
+        }
+      }
+    }
+    EXPECT_EQ(Expected, NumDecoded);
+  }
+
+  std::unique_ptr<MCRegisterInfo> MRI;
+  std::unique_ptr<MCAsmInfo> MAI;
+  std::unique_ptr<MCInstrInfo> MII;
+  std::unique_ptr<MCSubtargetInfo> STI;
+  std::unique_ptr<MCContext> Ctx;
+  std::unique_ptr<AArch64Disassembler> DisAsm;
+};
+
+// Simple LCG, so that the sampled encodings are the same on every run.
+struct InsnGenerator {
+  uint32_t State;
+  InsnGenerator() : State(0x2545F491) {}
+  uint32_t next() { return State = State * 1664525 + 1013904223; }
+};
+
+TEST_F(AArch64DisassemblerTest, DirectMatchesTable) {
+  // A few known encodings: ret, nop, ldp, add (immediate), b.eq, fmov.
+  const uint32_t Known[] = {0xd65f03c0, 0xd503201f, 0xa9407bfd, 0x91004000,
+                            0x54000040, 0x1e201000, 0x00000000, 0xffffffff};
+  for (uint32_t Insn : Known)
+    checkSameDecoding(Insn);
+
+  InsnGenerator Gen;
+  for (unsigned i = 0; i != 1 << 18; ++i) {
+    checkSameDecoding(Gen.next());
+    if (HasFatalFailure())
+      return;
+  }
+}
+
+static void appendInsn(std::vector<uint8_t> &Text, uint32_t Insn) {
+  for (unsigned b = 0; b != 4; ++b)
+    Text.push_back(uint8_t(Insn >> (8 * b)));
+}
+
+TEST_F(AArch64DisassemblerTest, BatchMatchesSingle) {
+  // Find an encoding that doesn't decode, to check that batches stop there.
+  InsnGenerator Gen;
+  uint32_t Invalid;
+  for (;;) {
+    Invalid = Gen.next();
+    uint8_t Bytes[] = {uint8_t(Invalid), uint8_t(Invalid >> 8),
+                       uint8_t(Invalid >> 16), uint8_t(Invalid >> 24)};
+    MCInst MI;
+    uint64_t Size;
+    if (DisAsm->getInstruction(MI, Size, Bytes, 0, nulls(), nulls()) ==
+        MCDisassembler::Fail)
+      break;
+  }
+
+  // ldp, add, b.eq, ret, then the invalid encoding, then a trailing nop and
+  // a partial word.
+  std::vector<uint8_t> Text;
+  for (uint32_t Insn : {0xa9407bfdU, 0x91004000U, 0x54000040U, 0xd65f03c0U})
+    appendInsn(Text, Insn);
+  appendInsn(Text, Invalid);
+  appendInsn(Text, 0xd503201f);
+  Text.push_back(0x1f);
+
+  for (bool UseDefault : {false, true}) {
+    SCOPED_TRACE(UseDefault ? "default" : "AArch64");
+    for (size_t BatchSize : {1, 3, 4, 16}) {
+      checkBatchDecoding(Text, BatchSize, UseDefault);
+      // Past the invalid encoding: a single nop, then a partial word.
+      checkBatchDecoding(ArrayRef<uint8_t>(Text).slice(20), BatchSize,
+                         UseDefault);
+    }
+  }
+
+  // A larger sample, in batches of 16.
+  Text.clear();
+  for (unsigned i = 0; i != 1 << 12; ++i)
+    appendInsn(Text, Gen.next());
+  for (size_t Off = 0; Off < Text.size(); Off += 4) {
+    checkBatchDecoding(ArrayRef<uint8_t>(Text).slice(Off), 16, false);
+    if (HasFatalFailure())
+      return;
+  }
+}
+
+TEST_F(AArch64DisassemblerTest, BatchCommentEnds) {
+  // Without a symbolizer there are no comments, but there is one end offset
+  // per decoded instruction.
+  std::vector<uint8_t> Text;
+  for (uint32_t Insn : {0xd503201fU, 0xd65f03c0U})
+    appendInsn(Text, Insn);
+  MCInst Batch[4];
+  SmallVector<uint64_t, 4> Sizes, CommentEnds;
+  SmallString<64> Comments;
+  raw_svector_ostream CS(Comments);
+  EXPECT_EQ(2U, DisAsm->getInstructions(Text, 0, Batch, Sizes, nulls(), CS,
+                                        &CommentEnds));
+  ASSERT_EQ(2U, CommentEnds.size());
+  EXPECT_EQ(0U, CommentEnds[0]);
+  EXPECT_EQ(0U, CommentEnds[1]);
+}
+
+// Not run by default: compares the throughput of the decoders over a
+// synthetic 16MB text section. Run with --gtest_also_run_disabled_tests.
+TEST_F(AArch64DisassemblerTest, DISABLED_DecodeThroughput) {
+  std::vector<uint8_t> Text;
+  InsnGenerator Gen;
+  const unsigned NumInsns = 1 << 22;
+  Text.reserve(NumInsns * 4);
+  for (unsigned i = 0; i != NumInsns; ++i)
+    appendInsn(Text, Gen.next());
+  ArrayRef<uint8_t> Bytes(Text);
+
+  typedef MCDisassembler::DecodeStatus (AArch64Disassembler::*DecodeFn)(
+      MCInst &, uint64_t &, ArrayRef<uint8_t>, uint64_t, raw_ostream &,
+      raw_ostream &) const;
+  auto Run = [&](DecodeFn Fn, const char *Name) {
+    MCInst MI;
+    uint64_t Size;
+    unsigned NumDecoded = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (uint64_t Off = 0; Off < Bytes.size(); Off += 4) {
+      MI.clear();
+      if ((DisAsm.get()->*Fn)(MI, Size, Bytes.slice(Off), Off, nulls(),
+                              nulls()) != MCDisassembler::Fail)
+        ++NumDecoded;
+    }
+    std::chrono::duration<double> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    outs() << Name << ": " << NumDecoded << "/" << NumInsns << " decoded, "
+           << format("%.1f", NumInsns / Elapsed.count() / 1e6)
+           << " Minsn/s\n";
+  };
+  Run(&AArch64Disassembler::getInstructionFromTable, "table ");
+  Run(&AArch64Disassembler::getInstruction, "direct");
+
+  // The batch interface, the way MCObjectDisassembler and llvm-objdump use it:
+  // decoding stops at invalid encodings, which are then skipped one by one.
+  {
+    const size_t BatchSize = 64;
+    MCInst Batch[BatchSize];
+    SmallVector<uint64_t, BatchSize> Sizes;
+    unsigned NumDecoded = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for (uint64_t Off = 0; Off < Bytes.size();) {
+      size_t N = DisAsm->getInstructions(Bytes.slice(Off), Off, Batch, Sizes);
+      NumDecoded += N;
+      Off += 4 * N;
+      if (N != BatchSize)
+        Off += 4;
+    }
+    std::chrono::duration<double> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    outs() << "batch : " << NumDecoded << "/" << NumInsns << " decoded, "
+           << format("%.1f", NumInsns / Elapsed.count() / 1e6)
+           << " Minsn/s\n";
+  }
+}
+
+} // end anonymous namespace
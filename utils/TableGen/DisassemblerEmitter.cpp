@@ -103,6 +103,14 @@ extern void EmitFixedLenDecoder(RecordKeeper &RK, raw_ostream &OS,
                                 std::string RFail,
                                 std::string L);
 
+extern void EmitFixedLenDecoderDirect(RecordKeeper &RK, raw_ostream &OS,
+                                      std::string PredicateNamespace,
+                                      std::string GPrefix,
+                                      std::string GPostfix,
+                                      std::string ROK,
+                                      std::string RFail,
+                                      std::string L);
+
 void EmitDisassembler(RecordKeeper &Records, raw_ostream &OS) {
   CodeGenTarget Target(Records);
   emitSourceFileHeader(" * " + Target.getName() + " Disassembler", OS);
@@ -146,4 +154,37 @@ void EmitDisassembler(RecordKeeper &Records, raw_ostream &OS) {
                       "MCDisassembler::Success", "MCDisassembler::Fail", "");
 }
 
+void EmitDisassemblerDirect(RecordKeeper &Records, raw_ostream &OS) {
+  CodeGenTarget Target(Records);
+  emitSourceFileHeader(" * " + Target.getName() + " Direct Disassembler", OS);
+
+  // The direct-dispatch decoder is only available for the fixed-length
+  // decoder tables, and is included after the regular disassembler tables.
+  if (Target.getName() == "X86") {
+    PrintError(Target.getTargetRecord()->getLoc(),
+               "Direct disassembler not supported for X86");
+    return;
+  }
+
+  // ARM and Thumb have a CHECK() macro to deal with DecodeStatuses.
+  if (Target.getName() == "ARM" || Target.getName() == "Thumb" ||
+      Target.getName() == "AArch64" || Target.getName() == "ARM64") {
+    std::string PredicateNamespace = Target.getName();
+    if (PredicateNamespace == "Thumb")
+      PredicateNamespace = "ARM";
+
+    EmitFixedLenDecoderDirect(Records, OS, PredicateNamespace,
+                              "if (!Check(S, ", "))",
+                              "S", "MCDisassembler::Fail",
+                              "  MCDisassembler::DecodeStatus S = "
+                                "MCDisassembler::Success;\n(void)S;");
+    return;
+  }
+
+  EmitFixedLenDecoderDirect(Records, OS, Target.getName(),
+                            "if (", " == MCDisassembler::Fail)",
+                            "MCDisassembler::Success", "MCDisassembler::Fail",
+                            "");
+}
+
 } // End llvm namespace
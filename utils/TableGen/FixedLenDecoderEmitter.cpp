@@ -27,6 +27,7 @@
 #include "llvm/TableGen/Error.h"
 #include "llvm/TableGen/Record.h"
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -106,10 +107,31 @@ public:
                            DecoderSet &Decoders,
                            unsigned Indentation) const;
 
+  // Emit the decoder state machine table as straight-line C++ code.
+  void emitDirectDecoder(formatted_raw_ostream &OS, const DecoderTable &Table,
+                         const DecoderTableInfo &TableInfo, unsigned BitWidth,
+                         StringRef Namespace) const;
+  void emitDirectDecoderFunctions(formatted_raw_ostream &OS,
+                                  const DecoderSet &Decoders) const;
+
   // run - Output the code emitter
   void run(raw_ostream &o);
 
+  // runDirect - Output the direct-dispatch decoder functions.
+  void runDirect(raw_ostream &o);
+
 private:
+  // A decoder table, along with the namespace and width it decodes.
+  struct NamedDecoderTable {
+    std::string Namespace;
+    unsigned BitWidth;
+    DecoderTable Table;
+  };
+
+  // Build the decoder tables for all namespace+width combinations.
+  void buildTables(std::vector<NamedDecoderTable> &Tables,
+                   DecoderTableInfo &TableInfo);
+
   CodeGenTarget Target;
 public:
   std::string PredicateNamespace;
@@ -2233,20 +2255,8 @@ static void emitDecodeInstruction(formatted_raw_ostream &OS) {
      << "}\n\n";
 }
 
-// Emits disassembler code for instruction decoding.
-void FixedLenDecoderEmitter::run(raw_ostream &o) {
-  formatted_raw_ostream OS(o);
-  OS << "#include \"llvm/MC/MCInst.h\"\n";
-  OS << "#include \"llvm/Support/Debug.h\"\n";
-  OS << "#include \"llvm/Support/DataTypes.h\"\n";
-  OS << "#include \"llvm/Support/LEB128.h\"\n";
-  OS << "#include \"llvm/Support/raw_ostream.h\"\n";
-  OS << "#include <assert.h>\n";
-  OS << '\n';
-  OS << "namespace llvm {\n\n";
-
-  emitFieldFromInstruction(OS);
-
+void FixedLenDecoderEmitter::buildTables(std::vector<NamedDecoderTable> &Tables,
+                                         DecoderTableInfo &TableInfo) {
   Target.reverseBitsForLittleEndianEncoding();
 
   // Parameterize the decoders based on namespace and instruction width.
@@ -2274,7 +2284,6 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
     }
   }
 
-  DecoderTableInfo TableInfo;
   for (const auto &Opc : OpcMap) {
     // Emit the decoder for this namespace+width combination.
     FilterChooser FC(*NumberedInstructions, Opc.second, Operands,
@@ -2298,8 +2307,34 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
 
     TableInfo.Table.push_back(MCD::OPC_Fail);
 
-    // Print the table to the output stream.
-    emitTable(OS, TableInfo.Table, 0, FC.getBitWidth(), Opc.first.first);
+    Tables.push_back(NamedDecoderTable());
+    Tables.back().Namespace = Opc.first.first;
+    Tables.back().BitWidth = FC.getBitWidth();
+    std::swap(Tables.back().Table, TableInfo.Table);
+  }
+}
+
+// Emits disassembler code for instruction decoding.
+void FixedLenDecoderEmitter::run(raw_ostream &o) {
+  formatted_raw_ostream OS(o);
+  OS << "#include \"llvm/MC/MCInst.h\"\n";
+  OS << "#include \"llvm/Support/Debug.h\"\n";
+  OS << "#include \"llvm/Support/DataTypes.h\"\n";
+  OS << "#include \"llvm/Support/LEB128.h\"\n";
+  OS << "#include \"llvm/Support/raw_ostream.h\"\n";
+  OS << "#include <assert.h>\n";
+  OS << '\n';
+  OS << "namespace llvm {\n\n";
+
+  emitFieldFromInstruction(OS);
+
+  DecoderTableInfo TableInfo;
+  std::vector<NamedDecoderTable> Tables;
+  buildTables(Tables, TableInfo);
+
+  // Print the tables to the output stream.
+  for (auto &T : Tables) {
+    emitTable(OS, T.Table, 0, T.BitWidth, T.Namespace);
     OS.flush();
   }
 
@@ -2315,6 +2350,322 @@ void FixedLenDecoderEmitter::run(raw_ostream &o) {
   OS << "\n} // End llvm namespace\n";
 }
 
+//////////////////////////////////////
+//                                  //
+// Direct-dispatch decoder emission //
+//                                  //
+//////////////////////////////////////
+
+namespace {
+// A decoded entry of the decoder state machine table.
+struct DecoderTableOp {
+  uint8_t Kind;
+  unsigned Pos;      // Position of the entry in the table.
+  unsigned Next;     // Position of the following entry.
+  unsigned Skip;     // Position to continue at when the entry fails.
+  unsigned Start, Len;
+  uint64_t Value;    // Filter/check value, predicate index, or opcode.
+  unsigned DecodeIdx;
+  uint64_t PositiveMask, NegativeMask;
+
+  DecoderTableOp()
+    : Kind(0), Pos(0), Next(0), Skip(0), Start(0), Len(0), Value(0),
+      DecodeIdx(0), PositiveMask(0), NegativeMask(0) {}
+
+  // Returns true if execution can continue at the next entry in the table.
+  bool canFallThrough() const {
+    return Kind != MCD::OPC_Decode && Kind != MCD::OPC_TryDecode &&
+           Kind != MCD::OPC_Fail;
+  }
+};
+} // End anonymous namespace
+
+static void parseDecoderTable(const DecoderTable &Table,
+                              std::vector<DecoderTableOp> &Ops) {
+  const uint8_t *Begin = Table.data(), *Ptr = Begin;
+  const uint8_t *End = Begin + Table.size();
+  auto ReadULEB = [&]() {
+    unsigned Len;
+    uint64_t V = decodeULEB128(Ptr, &Len);
+    Ptr += Len;
+    return V;
+  };
+  auto ReadSkip = [&]() {
+    unsigned NumToSkip = *Ptr++;
+    NumToSkip |= (*Ptr++) << 8;
+    return unsigned(Ptr - Begin) + NumToSkip;
+  };
+
+  while (Ptr != End) {
+    DecoderTableOp Op;
+    Op.Pos = Ptr - Begin;
+    Op.Kind = *Ptr++;
+    switch (Op.Kind) {
+    default:
+      PrintFatalError("invalid decode table opcode");
+    case MCD::OPC_ExtractField:
+      Op.Start = *Ptr++;
+      Op.Len = *Ptr++;
+      break;
+    case MCD::OPC_FilterValue:
+      Op.Value = ReadULEB();
+      Op.Skip = ReadSkip();
+      break;
+    case MCD::OPC_CheckField:
+      Op.Start = *Ptr++;
+      Op.Len = *Ptr++;
+      Op.Value = ReadULEB();
+      Op.Skip = ReadSkip();
+      break;
+    case MCD::OPC_CheckPredicate:
+      Op.Value = ReadULEB();
+      Op.Skip = ReadSkip();
+      break;
+    case MCD::OPC_Decode:
+      Op.Value = ReadULEB();
+      Op.DecodeIdx = ReadULEB();
+      break;
+    case MCD::OPC_TryDecode:
+      Op.Value = ReadULEB();
+      Op.DecodeIdx = ReadULEB();
+      Op.Skip = ReadSkip();
+      break;
+    case MCD::OPC_SoftFail:
+      Op.PositiveMask = ReadULEB();
+      Op.NegativeMask = ReadULEB();
+      break;
+    case MCD::OPC_Fail:
+      break;
+    }
+    Op.Next = Ptr - Begin;
+    Ops.push_back(Op);
+  }
+}
+
+void FixedLenDecoderEmitter::
+emitDirectDecoderFunctions(formatted_raw_ostream &OS,
+                           const DecoderSet &Decoders) const {
+  // Each decoder gets its own function, so that the leaves of the decoding
+  // tree call it directly instead of going through decodeToMCInst's switch.
+  unsigned Index = 0;
+  for (const auto &Decoder : Decoders) {
+    OS << "template<typename InsnType>\n";
+    OS << "static DecodeStatus decodeToMCInstDirect" << Index++
+       << "(DecodeStatus S, InsnType insn, MCInst &MI,\n";
+    OS << "    uint64_t Address, const void *Decoder, bool &DecodeComplete) {\n";
+    OS << "  DecodeComplete = true;\n";
+    OS << "  InsnType tmp;\n";
+    OS << "  (void)tmp;\n";
+    // The decoder bodies are emitted at a 4-space indentation.
+    OS << Decoder;
+    OS << "  return S;\n";
+    OS << "}\n\n";
+  }
+}
+
+void FixedLenDecoderEmitter::emitDirectDecoder(formatted_raw_ostream &OS,
+                                               const DecoderTable &Table,
+                                               const DecoderTableInfo &TableInfo,
+                                               unsigned BitWidth,
+                                               StringRef Namespace) const {
+  std::vector<DecoderTableOp> Ops;
+  parseDecoderTable(Table, Ops);
+
+  std::map<unsigned, unsigned> OpAtPos;
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+    OpAtPos[Ops[i].Pos] = i;
+
+  // An OPC_ExtractField immediately followed by a chain of OPC_FilterValue
+  // entries, each skipping to the next on mismatch, is a sequential test of
+  // the same field against distinct values: lower it to a switch, which the
+  // compiler turns into a jump table when the values are dense.
+  struct SwitchInfo {
+    std::vector<std::pair<uint64_t, unsigned>> Cases;
+    unsigned Default;
+  };
+  std::map<unsigned, SwitchInfo> Switches;
+  std::vector<bool> InChain(Ops.size(), false);
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i) {
+    if (Ops[i].Kind != MCD::OPC_ExtractField)
+      continue;
+    SwitchInfo SI;
+    unsigned j = i + 1;
+    while (j != e && Ops[j].Kind == MCD::OPC_FilterValue) {
+      SI.Cases.push_back(std::make_pair(Ops[j].Value, Ops[j].Next));
+      InChain[j] = true;
+      auto It = OpAtPos.find(Ops[j].Skip);
+      assert(It != OpAtPos.end() && "filter skips outside the table!");
+      j = It->second;
+    }
+    if (SI.Cases.empty())
+      continue;
+    SI.Default = Ops[j].Pos;
+    Switches[i] = std::move(SI);
+  }
+
+  // Decide which table entries need code and which positions need a label.
+  // Filters that are part of a switch only need to be emitted if something
+  // other than the switch can reach them.
+  std::vector<bool> Emit(Ops.size());
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+    Emit[i] = !InChain[i];
+  std::set<unsigned> Targets;
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    Targets.clear();
+    bool PrevFallsThrough = false;
+    for (unsigned i = 0, e = Ops.size(); i != e; ++i) {
+      const DecoderTableOp &Op = Ops[i];
+      if (!Emit[i] && (PrevFallsThrough || Targets.count(Op.Pos))) {
+        Emit[i] = Changed = true;
+      }
+      if (!Emit[i])
+        continue;
+      auto SI = Switches.find(i);
+      if (SI != Switches.end()) {
+        for (const auto &Case : SI->second.Cases)
+          Targets.insert(Case.second);
+        Targets.insert(SI->second.Default);
+        PrevFallsThrough = false;
+        continue;
+      }
+      if (Op.Kind != MCD::OPC_ExtractField && Op.Kind != MCD::OPC_SoftFail &&
+          Op.Kind != MCD::OPC_Decode && Op.Kind != MCD::OPC_Fail)
+        Targets.insert(Op.Skip);
+      PrevFallsThrough = Op.canFallThrough();
+    }
+    // Labels may refer to entries before their user; make sure those are
+    // emitted too.
+    for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+      if (!Emit[i] && Targets.count(Ops[i].Pos))
+        Emit[i] = Changed = true;
+  }
+
+  // The entry point takes the feature bits directly, so that callers decoding
+  // many instructions at once only need to look them up once.
+  OS << "template<typename InsnType>\n";
+  OS << "static DecodeStatus decodeInstructionDirect" << Namespace << BitWidth
+     << "(MCInst &MI, InsnType insn,\n";
+  OS << "    uint64_t Address, const void *DisAsm, const FeatureBitset &Bits) {\n";
+  OS << "  (void)Bits;\n";
+  OS << "  DecodeStatus S = MCDisassembler::Success;\n";
+  OS << "  bool DecodeComplete;\n";
+  OS << "  InsnType CurFieldValue = 0;\n";
+  OS << "  (void)CurFieldValue;\n";
+  OS << "  // Scratch instruction for decoders that may not complete; the\n";
+  OS << "  // caller's MCInst is only written once a decoder commits.\n";
+  OS << "  MCInst TmpMI;\n";
+  OS << "  (void)TmpMI;\n";
+
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i) {
+    if (!Emit[i])
+      continue;
+    const DecoderTableOp &Op = Ops[i];
+    if (Targets.count(Op.Pos))
+      OS << "L" << Op.Pos << ":\n";
+
+    switch (Op.Kind) {
+    case MCD::OPC_ExtractField: {
+      OS << "  CurFieldValue = fieldFromInstruction(insn, " << Op.Start << ", "
+         << Op.Len << ");\n";
+      auto SI = Switches.find(i);
+      if (SI == Switches.end())
+        break;
+      OS << "  switch (CurFieldValue) {\n";
+      for (const auto &Case : SI->second.Cases)
+        OS << "  case " << Case.first << ": goto L" << Case.second << ";\n";
+      OS << "  default: goto L" << SI->second.Default << ";\n";
+      OS << "  }\n";
+      break;
+    }
+    case MCD::OPC_FilterValue:
+      OS << "  if (CurFieldValue != " << Op.Value << ") goto L" << Op.Skip
+         << ";\n";
+      break;
+    case MCD::OPC_CheckField:
+      OS << "  if (fieldFromInstruction(insn, " << Op.Start << ", " << Op.Len
+         << ") != " << Op.Value << ") goto L" << Op.Skip << ";\n";
+      break;
+    case MCD::OPC_CheckPredicate:
+      OS << "  if (!(" << TableInfo.Predicates[Op.Value] << ")) goto L"
+         << Op.Skip << ";\n";
+      break;
+    case MCD::OPC_Decode:
+      OS << "  // Opcode: "
+         << NumberedInstructions->at(Op.Value)->TheDef->getName() << "\n";
+      OS << "  MI.clear();\n";
+      OS << "  MI.setOpcode(" << Op.Value << ");\n";
+      OS << "  S = decodeToMCInstDirect" << Op.DecodeIdx
+         << "(S, insn, MI, Address, DisAsm, DecodeComplete);\n";
+      OS << "  assert(DecodeComplete);\n";
+      OS << "  return S;\n";
+      break;
+    case MCD::OPC_TryDecode:
+      OS << "  // Opcode: "
+         << NumberedInstructions->at(Op.Value)->TheDef->getName() << "\n";
+      OS << "  TmpMI.clear();\n";
+      OS << "  TmpMI.setOpcode(" << Op.Value << ");\n";
+      OS << "  S = decodeToMCInstDirect" << Op.DecodeIdx
+         << "(S, insn, TmpMI, Address, DisAsm, DecodeComplete);\n";
+      OS << "  if (DecodeComplete) {\n";
+      OS << "    MI = TmpMI;\n";
+      OS << "    return S;\n";
+      OS << "  }\n";
+      OS << "  assert(S == MCDisassembler::Fail);\n";
+      OS << "  // Reset decode status. This also drops a SoftFail status that\n";
+      OS << "  // could be set before the decode attempt.\n";
+      OS << "  S = MCDisassembler::Success;\n";
+      OS << "  goto L" << Op.Skip << ";\n";
+      break;
+    case MCD::OPC_SoftFail:
+      OS << "  if ((insn & InsnType(0x" << utohexstr(Op.PositiveMask)
+         << "ULL)) || (~insn & InsnType(0x" << utohexstr(Op.NegativeMask)
+         << "ULL)))\n";
+      OS << "    S = MCDisassembler::SoftFail;\n";
+      break;
+    case MCD::OPC_Fail:
+      OS << "  return MCDisassembler::Fail;\n";
+      break;
+    }
+  }
+  OS << "}\n\n";
+
+  OS << "template<typename InsnType>\n";
+  OS << "static DecodeStatus decodeInstructionDirect" << Namespace << BitWidth
+     << "(MCInst &MI, InsnType insn,\n";
+  OS << "    uint64_t Address, const void *DisAsm, const MCSubtargetInfo &STI) {\n";
+  OS << "  return decodeInstructionDirect" << Namespace << BitWidth
+     << "(MI, insn, Address, DisAsm, STI.getFeatureBits());\n";
+  OS << "}\n\n";
+}
+
+// Emits the direct-dispatch decoder: the same decoding tree as run(), but
+// compiled to C++ control flow rather than interpreted from a table. This is
+// meant to be included after the output of run(), whose fieldFromInstruction
+// helper it uses.
+void FixedLenDecoderEmitter::runDirect(raw_ostream &o) {
+  formatted_raw_ostream OS(o);
+  OS << "#include \"llvm/MC/MCInst.h\"\n";
+  OS << "#include \"llvm/Support/DataTypes.h\"\n";
+  OS << "#include <assert.h>\n";
+  OS << '\n';
+  OS << "namespace llvm {\n\n";
+
+  DecoderTableInfo TableInfo;
+  std::vector<NamedDecoderTable> Tables;
+  buildTables(Tables, TableInfo);
+
+  emitDirectDecoderFunctions(OS, TableInfo.Decoders);
+
+  for (auto &T : Tables) {
+    emitDirectDecoder(OS, T.Table, TableInfo, T.BitWidth, T.Namespace);
+    OS.flush();
+  }
+
+  OS << "\n} // End llvm namespace\n";
+}
+
 namespace llvm {
 
 void EmitFixedLenDecoder(RecordKeeper &RK, raw_ostream &OS,
@@ -2328,4 +2679,15 @@ void EmitFixedLenDecoder(RecordKeeper &RK, raw_ostream &OS,
                          ROK, RFail, L).run(OS);
 }
 
+void EmitFixedLenDecoderDirect(RecordKeeper &RK, raw_ostream &OS,
+                               std::string PredicateNamespace,
+                               std::string GPrefix,
+                               std::string GPostfix,
+                               std::string ROK,
+                               std::string RFail,
+                               std::string L) {
+  FixedLenDecoderEmitter(RK, PredicateNamespace, GPrefix, GPostfix,
+                         ROK, RFail, L).runDirect(OS);
+}
+
 } // End llvm namespace
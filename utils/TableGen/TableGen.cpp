@@ -30,6 +30,7 @@ enum ActionType {
   GenAsmWriter,
   GenAsmMatcher,
   GenDisassembler,
+  GenDisassemblerDirect,
   GenPseudoLowering,
   GenCallingConv,
   GenDAGISel,
@@ -62,6 +63,8 @@ namespace {
                                "Generate assembly writer"),
                     clEnumValN(GenDisassembler, "gen-disassembler",
                                "Generate disassembler"),
+                    clEnumValN(GenDisassemblerDirect, "gen-disassembler-direct",
+                               "Generate direct-dispatch disassembler"),
                     clEnumValN(GenPseudoLowering, "gen-pseudo-lowering",
                                "Generate pseudo instruction lowering"),
                     clEnumValN(GenAsmMatcher, "gen-asm-matcher",
@@ -120,6 +123,9 @@ bool LLVMTableGenMain(raw_ostream &OS, RecordKeeper &Records) {
   case GenDisassembler:
     EmitDisassembler(Records, OS);
     break;
+  case GenDisassemblerDirect:
+    EmitDisassemblerDirect(Records, OS);
+    break;
   case GenPseudoLowering:
     EmitPseudoLowering(Records, OS);
     break;